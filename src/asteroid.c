@@ -22,7 +22,6 @@
  *  Monroeville, PA 15146
  */
 
-#include <GL/glut.h>
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -30,328 +29,666 @@
 #include "asteroids3D.h"
 #include "vecops.h"
 
-static void gen_rand_ast(double, int, double);
+static void ast_catch_up(unsigned int);
+static void ast_rebase(void);
 static void gen_rand_asteroid(Asteroid *);
+static int init_asteroid_pool(unsigned int);
 static void init_asteroid_data(void);
-static void init_asteroid_dls(void);
+static unsigned int lod_step(unsigned int);
+static unsigned int lod_tier(const Vector *, const Vector *);
+static void move_asteroids(unsigned int, unsigned int, unsigned int);
 
-/* Asteroid linked list head and tail pointers */
-Node *al_head, *al_tail;
+/* Unless optmap.max_asteroids says otherwise, the pool holds this many times
+the starting number of asteroids, which leaves room for the fragments of
+several generations of hits. */
+#define AST_POOL_SLACK 4
 
-/* Asteroid display list */
-int ast_dl[NUM_AST_TYPES];
+/* Alignment of each array inside the pool slab (one cache line) */
+#define AST_POOL_ALIGN 64
 
-/* Asteroid texture object list */
-unsigned int ast_tex[NUM_AST_TYPES];
+/* How far the player may get from afield.origin on any axis before the
+AST_FLOAT32 layout moves the origin, see ast_rebase() */
+#define AST_REBASE_DIST ABOUND
 
 /*
- * List of asteroids to be deleted each frame.
- * This list actually contains the node PRIOR to the node to be deleted (so I can
-hook PRIOR node to the deleted node's "next" node. Hence the name. In any given
-frame, the largest number of asteroids that can possibly be deleted is
-MAX_TORPS so I make an array of this number of node pointers, just in case.
-Initialized in init_asteroids(). */
-Node *delete_next_ast[MAX_TORPS];
+ * Simulation LOD, see move_asteroids(). A rock in tier t is moved every
+LOD_PERIOD(t) ticks; the tier follows from its distance to the ship or the
+nearest torp. A rock is never left alone for so long that it could come
+within LOD_SAFE_DIST of either, which covers the collision warning (12)
+and every hit test, or reach the wrap boundary.
+ */
+#define LOD_NEAR        0
+#define LOD_MID         1
+#define LOD_FAR         2
+#define NUM_LOD_TIERS   3
+#define LOD_PERIOD(t)   (1U << (t))
+#define LOD_NEAR_DIST   24.0
+#define LOD_MID_DIST    48.0
+#define LOD_SAFE_DIST   16.0
+#define LOD_BATCH       128 // rocks moved per kernel call
+
+/* Asteroid storage. All arrays are carved out of one slab allocated in
+init_asteroids(); slots [count, capacity) form the free list, so allocating
+and freeing an asteroid never touches the heap. */
+AsteroidField afield;
+
+/*
+ * Kill set: the asteroids to be deleted at the end of the tick. Deletion is
+deferred until process_deleted_ast() so that indices stay stable while the
+field is being walked, which also makes an index a stable identity for the
+whole tick. kill_mark[i] is set while asteroid i is on kill_list, so a rock
+hit twice is queued once. Both arrays live in the pool slab and are sized
+by its capacity, so every asteroid can be killed in the same tick.
+ */
+static unsigned int *kill_list;
+static unsigned char *kill_mark;
+static unsigned int num_kills;
+
+// Handle of the targeted asteroid
+Handle current_target = NO_HANDLE_INIT;
 
 int num_asteroids_on_scanner; // Number of asteroids (for ship's "scanner")
 
+/* Collision warning directions found by each chunk of move_asteroids() */
+static unsigned int cwg_chunk[MAX_WORKERS];
+
+/* The player's position relative to afield.origin, for move_asteroids() */
+static Vector move_center;
+
+/* LOD statistics: rocks per tier after the last tick, and the moves made
+in each tier so far against those a full-rate update would have made */
+static unsigned int lod_chunk_rocks[MAX_WORKERS][NUM_LOD_TIERS];
+static unsigned long lod_chunk_moves[MAX_WORKERS][NUM_LOD_TIERS];
+static unsigned int lod_rocks[NUM_LOD_TIERS];
+static unsigned long lod_moves[NUM_LOD_TIERS], lod_full_moves;
+static const char *const lod_tier_name[] = {"near", "mid", "far"};
+
+/* Set up by process_asteroid_motion() for lod_tier(): the ship and the
+torps in flight, and how fast the ship or a torp can close in on a rock */
+static Vector lod_point[1 + MAX_TORPS];
+static unsigned int lod_num_points;
+static double lod_chaser_speed;
+
 //-----------------------------------------------------------------------------
 void init_asteroids(void)
 {
+	/* the LOD figures are those of the current field */
+	memset(lod_moves, 0, sizeof(lod_moves));
+	lod_full_moves = 0;
 	init_asteroid_data();
-	init_asteroid_dls();
-
-	/* initialize asteroid deletion list */
-	memset(delete_next_ast, 0, sizeof(delete_next_ast));
+	init_integrate();
 	return;
 }
 
 static void init_asteroid_data(void)
 {
-	Node *current = NULL;
-	int i;
-
-	/* al_head is a dummy node, the first real node is al_head->next */
-	al_head = add_node();
-	al_tail = al_head;
-	current = al_head;
+	unsigned int capacity = optmap.max_asteroids, j;
+	Asteroid a;
+	Vector *v;
+	int i, k;
+
+	if (capacity == 0)
+		capacity = optmap.num_asteroids * AST_POOL_SLACK;
+	if (capacity < optmap.num_asteroids)
+		capacity = optmap.num_asteroids;
+	if (!init_asteroid_pool(capacity) || !init_broadphase()) {
+		fprintf(stderr, "Could not allocate room for %u asteroids\n",
+		        capacity);
+		exit(EXIT_FAILURE);
+	}
 
+	vec_zero(&a.pos);
+	vec_zero(&a.velocity);
+	vec_zero(&a.rot_axis);
 	for (i = 0; i < optmap.num_asteroids; ++i) {
-		if (current->next == NULL)
-			current->next = add_node();
+		if ((k = ast_alloc()) < 0)
+			break;
+		gen_rand_asteroid(&a);
+		ast_store(k, &a);
+	}
+
+	/* The field's vectors are drawn into a scratch array of doubles, as
+	the field may hold floats. It has room for the velocities in v[j] and
+	the spin axes in v[count+j]. */
+	if ((v = calloc(2 * afield.count + 1, sizeof(Vector))) == NULL) {
+		perror("calloc");
+		exit(EXIT_FAILURE);
+	}
 
-		current = current->next;
-		gen_rand_asteroid(&current->rock);
+	/* scatter the whole field at once, one coordinate at a time */
+	for (k = 0; k < 3; ++k)
+		gen_rand_floats(&v[0].x + k, afield.count,
+		    sizeof(Vector) / sizeof(double), -AGB, AGB);
+	ast_foreach(j)
+		ast_set_pos(j, &v[j]);
+
+	/* headings and spin axes in two batches, then the speeds */
+	gen_rand_unit_vecs(v, afield.count);
+	gen_rand_unit_vecs(v + afield.count, afield.count);
+	ast_foreach(j) {
+		vec_smul(&v[j], &v[j], gen_rand_float(0, MAX_APD));
+		ast_set_vel(j, &v[j]);
+		astvec_narrow(&afield.rot_axis[j], &v[afield.count+j]);
 	}
 
-	al_tail = current;
+	free(v);
 	return;
 }
 
 static void gen_rand_asteroid(Asteroid *a)
 {
-	double k;
-
 	a->type   = gen_rand_int(0, NUM_AST_TYPES - 1);
-	a->mass   = MIN_AST_MASS + AST_MASS_K * a->type;  /* based on type */
-	a->radius = static_cast(double, a->type + 1) / 2; // based on type
-	a->pos.x  = gen_rand_float(-AGB, AGB);
-	a->pos.y  = gen_rand_float(-AGB, AGB);
-	a->pos.z  = gen_rand_float(-AGB, AGB);
-
-	k = gen_rand_float(0, MAX_APD);
-	gen_rand_vec(&a->velocity);
-	vec_smul(&a->velocity, &a->velocity, k);
+	a->mass   = AST_MASS(a->type);
+	a->radius = AST_RADIUS(a->type);
+	/* a->pos, a->velocity and a->rot_axis are generated for the whole
+	field by init_asteroid_data() */
 	a->rot = 0;
 	a->rot_delta = gen_rand_int(-MAX_ARD, MAX_ARD);
-	gen_rand_vec(&a->rot_axis);
 	return;
 }
 
 void process_asteroid_motion(int value)
 {
-	Node *previous = al_head, *current = al_head->next;
-
-	num_asteroids_on_scanner = 0;
-	cwg_rear = cwg_above = cwg_below = cwg_left = cwg_right = 0;
-
-	while (current != NULL) {
-		Asteroid *q = &current->rock;
-		++num_asteroids_on_scanner;
-
-		check_collision(previous);
-
-		vec_addmul(&q->pos, &q->pos, dt, &q->velocity);
-		q->rot += q->rot_delta * dt;
-		q->rot %= 360;
-
-		// wrap the asteroids around player
-		if (q->pos.x > pos.x + ABOUND)
-			q->pos.x = pos.x - ABOUND + 10;
-		if (q->pos.x < pos.x - ABOUND)
-			q->pos.x = pos.x + ABOUND - 10;
-		if (q->pos.y > pos.y + ABOUND)
-			q->pos.y = pos.y - ABOUND + 10;
-		if (q->pos.y < pos.y - ABOUND)
-			q->pos.y = pos.y + ABOUND - 10;
-		if (q->pos.z > pos.z + ABOUND)
-			q->pos.z = pos.z - ABOUND + 10;
-		if (q->pos.z < pos.z - ABOUND)
-			q->pos.z = pos.z + ABOUND - 10;
-
-		scan_for_collision_warning(q);
-		previous = current;
-		current  = current->next;
+	unsigned int i, t, dir = 0;
+
+	/* Collisions are tested against the positions at the start of the
+	tick. Fragments spawned by hits are appended to the field and get moved
+	below in the same tick. */
+	process_collisions();
+
+	/* Every rock moves on its own, so this part is split up among the
+	worker pool. The broadphase hash is shared and gets updated afterwards
+	in index order, which keeps the outcome identical for any number of
+	threads. */
+	ast_rebase();
+	vec_sub(&move_center, &pos, &afield.origin);
+	lod_point[0] = pos;
+	for (i = 0, lod_num_points = 1; i < MAX_TORPS; ++i)
+		if (torp[i].ttl != 0 && torp[i].in_flight_flag)
+			lod_point[lod_num_points++] = torp[i].pos;
+	lod_chaser_speed = vec_length(&velocity) + TORP_DELTA;
+	memset(cwg_chunk, 0, sizeof(cwg_chunk));
+	memset(lod_chunk_rocks, 0, sizeof(lod_chunk_rocks));
+	run_parallel(move_asteroids, afield.count);
+
+	/* Rocks left behind by the LOD keep their old cell. They are too far
+	from the ship and the torps to be looked for. */
+	ast_foreach(i)
+		if (afield.lag[i] == 0)
+			broadphase_move(i);
+	for (i = 0; i < MAX_WORKERS; ++i)
+		dir |= cwg_chunk[i];
+	set_collision_warning(dir);
+
+	memset(lod_rocks, 0, sizeof(lod_rocks));
+	for (i = 0; i < MAX_WORKERS; ++i)
+		for (t = 0; t < NUM_LOD_TIERS; ++t) {
+			lod_rocks[t] += lod_chunk_rocks[i][t];
+			lod_moves[t] += lod_chunk_moves[i][t];
+		}
+	memset(lod_chunk_moves, 0, sizeof(lod_chunk_moves));
+	lod_full_moves += afield.count;
+	num_asteroids_on_scanner = afield.count;
+	return;
+}
+
+/*
+ * Integrate, spin and wrap asteroids [first, last), gathering the collision
+ * warnings for their chunk.
+ *
+ * With optmap.sim_lod_flag set, only the near rocks are moved every tick.
+ * Mid and far rocks are moved every 2nd or 4th tick, by all the ticks they
+ * have missed at once; motion is linear, so this lands where single steps
+ * would. Which tick that is depends on the rock's id, which spreads the
+ * work evenly over the ticks. Meanwhile afield.lag counts the ticks owed,
+ * and ast_pos() adds them in, so everyone else sees the rock where it
+ * really is. The tier is chosen again after each move, which promotes a
+ * rock in time when it or the ship heads for the other.
+ *
+ * The rocks due are gathered LOD_BATCH at a time, with their velocities
+ * scaled by the ticks they are owed, so that the kernel still gets long
+ * runs to work on.
+ */
+static void move_asteroids(unsigned int chunk, unsigned int first,
+    unsigned int last)
+{
+	AstVec bpos[LOD_BATCH], bvel[LOD_BATCH];
+	unsigned int idx[LOD_BATCH], bstep[LOD_BATCH];
+	unsigned int i, j, k, m, n, dir = 0;
+	Vector p, v;
+
+	if (!optmap.sim_lod_flag) {
+		for (i = first; i < last; ++i)
+			if (afield.lag[i] != 0)
+				ast_catch_up(i);
+
+		// move and wrap the asteroids around player
+		integrate_wrap(&afield.pos[first], &afield.velocity[first],
+		               last - first, dt, &move_center);
+		for (i = first; i < last; ++i) {
+			afield.rot[i] += afield.rot_delta[i] * dt;
+			afield.rot[i] %= 360;
+			ast_pos(&p, i);
+			dir |= scan_for_collision_warning(&p);
+			afield.tier[i] = LOD_NEAR;
+		}
+		lod_chunk_rocks[chunk][LOD_NEAR] += last - first;
+		lod_chunk_moves[chunk][LOD_NEAR] += last - first;
+		cwg_chunk[chunk] = dir;
+		return;
+	}
+
+	for (i = first; i < last; ) {
+		for (m = 0; i < last && m < LOD_BATCH; ++i) {
+			if ((n = lod_step(i)) == 0) {
+				++afield.lag[i];
+				++lod_chunk_rocks[chunk][afield.tier[i]];
+				continue;
+			}
+			idx[m]    = i;
+			bstep[m]  = n;
+			bpos[m]   = afield.pos[i];
+			bvel[m].x = n * afield.velocity[i].x;
+			bvel[m].y = n * afield.velocity[i].y;
+			bvel[m].z = n * afield.velocity[i].z;
+			bvel[m].w = 0;
+			++m;
+		}
+
+		// move and wrap the asteroids around player
+		integrate_wrap(bpos, bvel, m, dt, &move_center);
+
+		for (k = 0; k < m; ++k) {
+			j = idx[k];
+			++lod_chunk_moves[chunk][afield.tier[j]];
+			afield.pos[j] = bpos[k];
+			afield.lag[j] = 0;
+			afield.rot[j] += afield.rot_delta[j] * (bstep[k] * dt);
+			afield.rot[j] %= 360;
+			ast_pos(&p, j);
+			dir |= scan_for_collision_warning(&p);
+			ast_vel(&v, j);
+			afield.tier[j] = lod_tier(&p, &v);
+			++lod_chunk_rocks[chunk][afield.tier[j]];
+		}
 	}
 
+	cwg_chunk[chunk] = dir;
 	return;
 }
 
-Node *add_node(void)
+/* Number of ticks to move asteroid i by this tick, 0 to leave it be */
+static unsigned int lod_step(unsigned int i)
 {
-	return calloc(1, sizeof(Node));
+	unsigned int period = LOD_PERIOD(afield.tier[i]);
+
+	/* once the LOD is switched off, every rock moves on its next tick */
+	if (optmap.sim_lod_flag && ((ticks + afield.id[i]) & (period - 1)) != 0)
+		return 0;
+	return afield.lag[i] + 1;
 }
 
-static void init_asteroid_dls(void)
+/* LOD tier for a rock just moved to p with velocity v */
+static unsigned int lod_tier(const Vector *p, const Vector *v)
 {
-	double k = 0.5;
-	int i;
+	double d, dd, reach, margin, gap;
+	unsigned int t, i;
+	Vector r;
+
+	vec_sub(&r, p, &lod_point[0]);
+	d = vec_dot(&r, &r);
+	for (i = 1; i < lod_num_points; ++i) {
+		vec_sub(&r, p, &lod_point[i]);
+		if ((dd = vec_dot(&r, &r)) < d)
+			d = dd;
+	}
 
-	for (i = 0; i < NUM_AST_TYPES; ++i) {
-		ast_dl[i] = glGenLists(1);
-		gen_rand_ast(0.2, ast_dl[i], k);
-		k += 0.5;
+	if (d < LOD_NEAR_DIST * LOD_NEAR_DIST)
+		return LOD_NEAR;
+	t = (d < LOD_MID_DIST * LOD_MID_DIST) ? LOD_MID : LOD_FAR;
+
+	/* How fast the gap can close: the rock, the ship, and a torp that
+	may be fired meanwhile. The wrap boundary moves with the ship. The
+	rock's speed is overestimated by the sum of its components, and all
+	distances are compared squared, which saves the square roots. */
+	reach  = (fabs(v->x) + fabs(v->y) + fabs(v->z) + lod_chaser_speed) * dt;
+	margin = ABOUND - fabs(p->x - pos.x);
+	if ((dd = ABOUND - fabs(p->y - pos.y)) < margin)
+		margin = dd;
+	if ((dd = ABOUND - fabs(p->z - pos.z)) < margin)
+		margin = dd;
+	for (; t > LOD_NEAR; --t) {
+		gap = LOD_SAFE_DIST + reach * LOD_PERIOD(t);
+		if (d > gap * gap && margin > reach * LOD_PERIOD(t))
+			break;
 	}
+	return t;
+}
 
+void print_lod_stats(void)
+{
+	unsigned long moves = 0;
+	unsigned int t;
+
+	printf("Simulation LOD (%s):", optmap.sim_lod_flag ? "on" : "off");
+	for (t = 0; t < NUM_LOD_TIERS; ++t) {
+		printf(" %u %s rocks (%lu moves),", lod_rocks[t],
+		       lod_tier_name[t], lod_moves[t]);
+		moves += lod_moves[t];
+	}
+	printf(" %.1f%% of the full-rate moves\n",
+	       (lod_full_moves > 0) ? 100.0 * moves / lod_full_moves : 0);
 	return;
 }
 
-static void gen_rand_ast(double pert, int dl, double scalar)
+/*
+ * In the AST_FLOAT32 layout positions are stored relative to afield.origin,
+ * so that a float resolves them to about 1e-5 near the player however far
+ * the player has flown. The origin follows the player in steps: once the
+ * player is more than AST_REBASE_DIST away from it on any axis, it moves to
+ * the player and every position is shifted to match. The double layout
+ * keeps its origin at zero.
+ */
+static void ast_rebase(void)
 {
-#define P_SLICES 8
-#define T_SLICES 8
-	static const float ad[] = {1, 1, 1, 1};
-	double phi, theta;
-	double delta_p = M_PI / P_SLICES;
-	double delta_t = 2 * M_PI / T_SLICES;
-	int rows = P_SLICES - 1;
-	int cols = T_SLICES;
-	int i, j;
-	Vector sphere[P_SLICES - 1][T_SLICES];
-	double q = pert;
-	double tc[P_SLICES - 1][T_SLICES][2] ; /* these last variables are for texture coords */
-	double dts = 2.0 / rows, dtt = 4.0 / cols;
-	double s, t, len;
-	int side, side_len;
-
-	/* generate the points on the sphere and load them into a data structure
-	 *
-	 * This whole algorithm below makes sense if you know that theta
-	 * generates circles of points and phi moves from one end of the sphere
-	 * to the other modulating the radius of the circles generated by theta.
-	 *
-	 * so, each circular slice through the sphere is represented by "i" and
-	 * each point on a particular circle is represented by "j"
-	 *
-	 * use GL_LINE_LOOP instead of GL_QUAD_STRIP to display the sphere and you'll
-	 * see what I mean.
-	 */
-
-	s = 0;
-	for (i = 0, phi = delta_p; i < rows; phi += delta_p, ++i) {
-		double sinphi = sin(phi), cosphi = cos(phi);
-		t = 0;
-		for (j = 0, theta = 0; j < cols; theta += delta_t, ++j) {
-			sphere[i][j].x = cos(theta) * sinphi;
-			sphere[i][j].y = sin(theta) * sinphi;
-			sphere[i][j].z = cosphi;
-			tc[i][j][0] = s;
-			tc[i][j][1] = t;
-			t += dtt;
-		}
-		s += dts;
+#ifdef AST_FLOAT32
+	AstVec *p = afield.pos;
+	unsigned int i;
+	Vector d;
+
+	vec_sub(&d, &pos, &afield.origin);
+	if (fabs(d.x) <= AST_REBASE_DIST && fabs(d.y) <= AST_REBASE_DIST &&
+	    fabs(d.z) <= AST_REBASE_DIST)
+		return;
+
+	ast_foreach(i) {
+		p[i].x -= d.x;
+		p[i].y -= d.y;
+		p[i].z -= d.z;
 	}
+	afield.origin = pos;
+#endif
+	return;
+}
 
-	/* randomly perturb the points q = 0.1 is good */
-	for (i = 0, phi = delta_p; i < rows; phi += delta_p, ++i)
-		for (j = 0, theta = 0; j < cols; theta += delta_t, ++j) {
-			sphere[i][j].x += gen_rand_float(-q, q);
-			sphere[i][j].y += gen_rand_float(-q, q);
-			sphere[i][j].z += gen_rand_float(-q, q);
-		}
+static int init_asteroid_pool(unsigned int capacity)
+{
+	AsteroidField *f = &afield;
+	size_t vsz, isz, msz, cold;
+	unsigned int i;
+	char *slab;
+
+#define ALIGN_UP(x) (((x) + AST_POOL_ALIGN - 1) & ~(size_t)(AST_POOL_ALIGN - 1))
+	vsz = ALIGN_UP(capacity * sizeof(AstVec));
+	isz = ALIGN_UP(capacity * sizeof(int));
+	msz = ALIGN_UP(capacity * sizeof(*kill_mark));
+#undef ALIGN_UP
+
+	if (posix_memalign(reinterpret_cast(void **, &slab), AST_POOL_ALIGN,
+	    3 * vsz + 7 * isz + 3 * msz) != 0)
+		return 0;
+
+	/* run_benchmark() sets up a fresh field for each of its runs */
+	free(f->slab);
+	memset(f, 0, sizeof(*f));
+	/* the hot arrays first, then the cold ones */
+	cold = 2 * vsz + isz;
+	f->slab      = slab;
+	f->capacity  = capacity;
+	f->pos       = reinterpret_cast(AstVec *, slab);
+	f->velocity  = reinterpret_cast(AstVec *, slab + vsz);
+	f->type      = reinterpret_cast(int *, slab + 2 * vsz);
+	f->rot_axis  = reinterpret_cast(AstVec *, slab + cold);
+	f->rot       = reinterpret_cast(int *, slab + cold + vsz);
+	f->rot_delta = reinterpret_cast(int *, slab + cold + vsz + isz);
+	f->id        = reinterpret_cast(unsigned int *, slab + cold + vsz +
+	               2 * isz);
+	f->id_index  = reinterpret_cast(unsigned int *, slab + cold + vsz +
+	               3 * isz);
+	f->id_generation = reinterpret_cast(unsigned int *,
+	                   slab + cold + vsz + 4 * isz);
+	for (i = 0; i < capacity; ++i) {
+		f->id[i] = f->id_index[i] = i;
+		f->id_generation[i] = 0;
+	}
 
-	/* create asteroid display list */
-	glNewList(dl, GL_COMPILE);
-	glShadeModel(GL_FLAT);
-	glMaterialfv(GL_FRONT, GL_AMBIENT_AND_DIFFUSE, ad);
-	glScalef(scalar, scalar, scalar);
-
-	/* asteroid body */
-	glBegin(GL_QUAD_STRIP);
-	for (i = 0, phi = delta_p; i < rows - 1; phi += delta_p, ++i) {
-		for (j = 0, theta = 0; j < cols; theta += delta_t, ++j) {
-			len = vec_length(&sphere[i][j]);
-			glNormal3f(sphere[i][j].x / len, sphere[i][j].y / len,
-			           sphere[i][j].z / len);
-			glTexCoord2f(tc[i][j][0], tc[i][j][1]);
-			glVertex3f(sphere[i][j].x, sphere[i][j].y,
-			           sphere[i][j].z);
-
-			len = vec_length(&sphere[i+1][j]);
-			glNormal3f(sphere[i+1][j].x / len,
-			           sphere[i+1][j].y / len,
-			           sphere[i+1][j].z / len);
-			glTexCoord2f(tc[i+1][j][0], tc[i+1][j][1]);
-			glVertex3f(sphere[i+1][j].x, sphere[i+1][j].y,
-			           sphere[i+1][j].z);
-		}
+	kill_list = reinterpret_cast(unsigned int *, slab + cold + vsz + 5 * isz);
+	kill_mark = reinterpret_cast(unsigned char *, slab + cold + vsz +
+	            6 * isz);
+	f->tier   = kill_mark + msz;
+	f->lag    = kill_mark + 2 * msz;
+	memset(kill_mark, 0, 3 * msz);
+	num_kills = 0;
+	return 1;
+}
 
-		len = vec_length(&sphere[i][0]);
-		glNormal3f(sphere[i][0].x / len, sphere[i][0].y / len,
-		           sphere[i][0].z / len);
-		glTexCoord2f(tc[i][j-1][0] + dts, tc[i][j-1][1] + dtt);
-		glVertex3f(sphere[i][0].x, sphere[i][0].y, sphere[i][0].z);
-
-		len = vec_length(&sphere[i+1][0]);
-		glNormal3f(sphere[i+1][0].x / len, sphere[i+1][0].y / len,
-		           sphere[i+1][0].z / len);
-		glTexCoord2f(tc[i+1][j-1][0] + dts, tc[i+1][j-1][1] + dtt);
-		glVertex3f(sphere[i+1][0].x, sphere[i+1][0].y,
-		           sphere[i+1][0].z);
-	}
-	glEnd();
-	/* asteroid ends */
-
-	/* generate the texture coords for this asteroid end */
-	s = t = 0;
-	side = 0;
-	side_len = cols / 4;
-	dts = 1.0 / side_len;
-
-	for (i = 0; i < cols; ++i) {
-		tc[0][i][0] = s;
-		tc[0][i][1] = t;
-
-		if (i % side_len == 0)
-		    ++side;
-		if (side == 1)
-			s += dts;
-		if (side == 2)
-			t += dts;
-		if (side == 3)
-			s -= dts;
-		if (side == 4)
-			t -= dts;
+/* Take a slot from the pool and return its index, or -1 if the pool is
+exhausted. The pool never grows, so pointers into afield stay valid. */
+int ast_alloc(void)
+{
+	unsigned int n = 1;
+
+	return ast_alloc_n(&n);
+}
+
+/* Take up to *n asteroids from the pool as one block at the end of the
+field. *n is cut down to what the pool had; returns the index of the first,
+or -1 if there was no room at all. */
+int ast_alloc_n(unsigned int *n)
+{
+	unsigned int first = afield.count;
+
+	if (*n > afield.capacity - first) {
+		afield.alloc_failures += *n - (afield.capacity - first);
+		*n = afield.capacity - first;
 	}
+	if (*n == 0)
+		return -1;
+
+	afield.count += *n;
+	if (afield.count > afield.peak)
+		afield.peak = afield.count;
+	return first;
+}
+
+/* Return asteroid i to the pool by moving the last asteroid into its slot.
+Its id goes to the free end, and the new generation orphans its handles. */
+void ast_remove(unsigned int i)
+{
+	unsigned int last, dead = afield.id[i];
+
+	broadphase_remove(i);
+	last = --afield.count;
+	++afield.id_generation[dead];
+	if (i == last)
+		return;
+
+	afield.pos[i]       = afield.pos[last];
+	afield.velocity[i]  = afield.velocity[last];
+	afield.rot_axis[i]  = afield.rot_axis[last];
+	afield.rot[i]       = afield.rot[last];
+	afield.rot_delta[i] = afield.rot_delta[last];
+	afield.type[i]      = afield.type[last];
+	afield.tier[i]      = afield.tier[last];
+	afield.lag[i]       = afield.lag[last];
+	afield.id[i]        = afield.id[last];
+	afield.id_index[afield.id[i]] = i;
+	afield.id[last]     = dead;
+	afield.id_index[dead] = last;
+	return;
+}
+
+/* Handle for asteroid i, valid for as long as the asteroid lives */
+void ast_handle(Handle *h, unsigned int i)
+{
+	h->index      = afield.id[i];
+	h->generation = afield.id_generation[h->index];
+	return;
+}
+
+/* Current index of the asteroid behind h, or -1 if it is gone */
+int ast_resolve(Handle h)
+{
+	if (h.index >= afield.capacity ||
+	    h.generation != afield.id_generation[h.index])
+		return -1;
+	return afield.id_index[h.index];
+}
 
-	glBegin(GL_TRIANGLE_FAN) ;
-		glTexCoord2f(0.5, 0.5);
-		glVertex3f(0, 0, 1);
-
-		for (i = 0; i < cols; ++i) {
-			len = vec_length(&sphere[0][i]);
-			glNormal3f(sphere[0][i].x / len, sphere[0][i].y / len,
-			           sphere[0][i].z / len);
-			glTexCoord2f(tc[0][i][0], tc[0][i][1]);
-			glVertex3f(sphere[0][i].x, sphere[0][i].y,
-			           sphere[0][i].z);
+/* Queue asteroid i for deletion at the end of the tick */
+void ast_kill(unsigned int i)
+{
+	if (kill_mark[i])
+		return;
+	kill_mark[i] = 1;
+	kill_list[num_kills++] = i;
+	return;
+}
+
+/*
+ * Delete the asteroids in the kill set, in one pass over the set.
+ * ast_remove() fills the hole with the last asteroid of the field, which
+ * may itself be waiting to die: such rocks are taken off the end first, so
+ * the one moved into the hole is always a survivor. A queued index at or
+ * past the end of the field was one of those and is already gone. Every
+ * rock is removed once, so this costs O(kills), and the marks are all
+ * clear again afterwards.
+ */
+void process_deleted_ast(void)
+{
+	unsigned int k, i, last;
+
+	for (k = 0; k < num_kills; ++k) {
+		i = kill_list[k];
+		if (i >= afield.count)
+			continue;
+		while ((last = afield.count - 1) != i && kill_mark[last]) {
+			kill_mark[last] = 0;
+			ast_remove(last);
 		}
+		kill_mark[i] = 0;
+		ast_remove(i);
+	}
+
+	num_kills = 0;
+	return;
+}
+
+/* Gather asteroid i into a standalone record */
+void ast_load(unsigned int i, Asteroid *a)
+{
+	a->type      = afield.type[i];
+	a->mass      = AST_MASS(a->type);
+	a->radius    = AST_RADIUS(a->type);
+	ast_pos(&a->pos, i);
+	ast_vel(&a->velocity, i);
+	a->rot       = afield.rot[i];
+	a->rot_delta = afield.rot_delta[i];
+	ast_axis(&a->rot_axis, i);
+	return;
+}
+
+/* Scatter a record into slot i; mass and radius follow from the type */
+void ast_store(unsigned int i, const Asteroid *a)
+{
+	afield.type[i]      = a->type;
+	ast_set_pos(i, &a->pos);
+	ast_set_vel(i, &a->velocity);
+	afield.rot[i]       = a->rot;
+	afield.rot_delta[i] = a->rot_delta;
+	astvec_narrow(&afield.rot_axis[i], &a->rot_axis);
+	afield.tier[i]      = LOD_NEAR;
+	return;
+}
+
+/*
+ * Vectors of asteroid i in the field, see AsteroidField. The position is
+ * kept relative to afield.origin in the AST_FLOAT32 layout and these make
+ * it absolute again; in the double layout the origin is not used. The
+ * ticks of motion the LOD still owes the rock are added in.
+ */
+void ast_pos(Vector *r, unsigned int i)
+{
+	Vector v;
+
+#ifdef AST_FLOAT32
+	const AstVec *p = &afield.pos[i];
+
+	r->x = afield.origin.x + p->x;
+	r->y = afield.origin.y + p->y;
+	r->z = afield.origin.z + p->z;
+	r->w = 0;
+#else
+	*r = afield.pos[i];
+#endif
+	if (afield.lag[i] != 0) {
+		ast_vel(&v, i);
+		vec_addmul(r, r, afield.lag[i] * dt, &v);
+	}
+	return;
+}
+
+void ast_set_pos(unsigned int i, const Vector *v)
+{
+#ifdef AST_FLOAT32
+	Vector r;
+
+	vec_sub(&r, v, &afield.origin);
+	astvec_narrow(&afield.pos[i], &r);
+#else
+	afield.pos[i] = *v;
+#endif
+	afield.lag[i] = 0;
+	return;
+}
+
+/* Apply the motion the LOD owes asteroid i before its velocity changes */
+static void ast_catch_up(unsigned int i)
+{
+	Vector p;
 
-		len = vec_length(&sphere[0][0]);
-		glNormal3f(sphere[0][0].x / len, sphere[0][0].y / len,
-		           sphere[0][0].z / len);
-		glTexCoord2f(tc[0][i-1][0], tc[0][i-1][1] - dts);
-		glVertex3f(sphere[0][0].x, sphere[0][0].y, sphere[0][0].z);
-	glEnd();
-
-	/* generate the texture coords for this asteroid end */
-	s = t = 0;
-	side = 0;
-	side_len = cols / 4;
-	dts = 1.0 / side_len;
-
-	for (i = 0; i < cols; ++i) {
-		tc[0][i][0] = s;
-		tc[0][i][1] = t;
-
-		if (i % side_len == 0)
-		    ++side;
-		if (side == 1)
-			s += dts;
-		if (side == 2)
-			t += dts;
-		if (side == 3)
-			s -= dts;
-		if (side == 4)
-			t -= dts;
+	if (afield.lag[i] != 0) {
+		ast_pos(&p, i);
+		ast_set_pos(i, &p);
 	}
+	return;
+}
 
-	glBegin(GL_TRIANGLE_FAN);
-		glVertex3f(0, 0, -1);
-
-		for (i = cols - 1; i >= 0; --i) {
-			len = vec_length(&sphere[rows-1][i]);
-			glNormal3f(sphere[rows-1][i].x / len,
-			           sphere[rows-1][i].y / len,
-			           sphere[rows-1][i].z / len);
-			glTexCoord2f(tc[rows-1][i][0], tc[rows-1][i][1]);
-			glVertex3f(sphere[rows-1][i].x,
-			           sphere[rows-1][i].y,
-			           sphere[rows-1][i].z);
-		}
+void ast_vel(Vector *r, unsigned int i)
+{
+	astvec_widen(r, &afield.velocity[i]);
+	return;
+}
+
+void ast_set_vel(unsigned int i, const Vector *v)
+{
+	ast_catch_up(i);
+	astvec_narrow(&afield.velocity[i], v);
+	return;
+}
+
+void ast_axis(Vector *r, unsigned int i)
+{
+	astvec_widen(r, &afield.rot_axis[i]);
+	return;
+}
 
-		len = vec_length(&sphere[rows-1][cols-1]);
-		glNormal3f(sphere[rows-1][cols-1].x / len,
-		           sphere[rows-1][cols-1].y / len,
-		           sphere[rows-1][cols-1].z / len);
-		glTexCoord2f(tc[rows-1][cols-1][0],
-		             tc[rows-1][cols-1][1] + dts);
-		glVertex3f(sphere[rows-1][cols-1].x,
-		           sphere[rows-1][cols-1].y,
-		           sphere[rows-1][cols-1].z);
-	glEnd();
-	glEndList();
+void print_asteroid_pool_stats(void)
+{
+	printf("Asteroid pool: %u/%u in use, peak %u, %lu allocation "
+	       "failures\n", afield.count, afield.capacity, afield.peak,
+	       afield.alloc_failures);
+	return;
+}
+
+/* return 1 if asteroid n IS targeted, return zero if it is NOT */
+int is_targeted(unsigned int n)
+{
+	return ast_resolve(current_target) == static_cast(int, n);
+}
+
+void drop_target(void)
+{
+	current_target = NO_HANDLE;
 	return;
-#undef P_SLICES
-#undef T_SLICES
 }
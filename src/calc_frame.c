@@ -22,46 +22,290 @@
  *  Monroeville, PA 15146
  */
 
+#include <errno.h>
 #include <pthread.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
 #include <unistd.h>
 #include "asteroids3D.h"
+#include "vecops.h"
 
 // Maximum rotation that can be input per unit time in degrees
 #define MAX_DPS_INPUT 75.0
 
+/* Most ticks run back to back to catch up when the sim thread has fallen
+behind its schedule. Beyond that the missed ticks are dropped and the
+schedule starts afresh from the current time. */
+#define MAX_CATCHUP_TICKS 5
+
+/* run_benchmark() always starts from this seed so its runs compare */
+#define BENCH_SEED 1
+
+/* Upper bounds (us) of the wakeup jitter histogram buckets. The last bucket
+takes everything above. */
+static const unsigned int jitter_bound[] =
+	{50, 100, 250, 500, 1000, 2500, 5000, 10000};
+#define NUM_JITTER_BUCKETS (sizeof(jitter_bound) / sizeof(*jitter_bound) + 1)
+
+static double bench_pass(unsigned int, unsigned long long *);
+static unsigned long long field_checksum(void);
+static void run_tick(double);
+static double timespec_diff(const struct timespec *,
+	const struct timespec *);
+static void timespec_add(struct timespec *, double);
+
+/* Achieved ticks per second over the last full second, for the HUD */
+double achieved_tps;
+
+/* Sim thread timing statistics, see print_frame_stats() */
+static unsigned long jitter_hist[NUM_JITTER_BUCKETS];
+static unsigned long late_ticks;    // catch-up ticks run behind schedule
+static unsigned long dropped_ticks; // ticks given up past MAX_CATCHUP_TICKS
+static unsigned long overrun_ticks; // ticks whose work took longer than dt
+static unsigned long run_ticks;     // ticks run while not paused
+static double run_time;             // seconds spent not paused
+static double stall_time, stall_max; // seconds waited for run_yield
+
 //-----------------------------------------------------------------------------
+/*
+ * The sim thread. Ticks are scheduled against absolute deadlines dt apart
+ * on the monotonic clock, so the time spent working and the scheduler's
+ * wakeup latency do not add up to a slower game. When a wakeup comes a
+ * whole tick or more after its deadline, the missed ticks are run at once.
+ */
 void *calculate_frame(void *unused)
 {
+	struct timespec deadline, now, window;
+	unsigned long due, window_ticks = 0;
+	double late, us;
+	unsigned int b;
+
+	rng_select(RNG_SIM);
+	achieved_tps = tps;
+	clock_gettime(CLOCK_MONOTONIC, &deadline);
+	window = deadline;
+
 	while (1) {
-		usleep(dt * 1000000);
+		timespec_add(&deadline, dt);
+		while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME,
+		       &deadline, NULL) == EINTR)
+			;
+		clock_gettime(CLOCK_MONOTONIC, &now);
 
-		if (paused()) /* must continue to compute dt even if paused. */
+		if (paused()) { /* keep the schedule from piling up ticks */
+			wait_while_paused();
+			clock_gettime(CLOCK_MONOTONIC, &now);
+			deadline = window = now;
+			window_ticks = 0;
 			continue;
+		}
 		if (game_end_flag)
 			break;
 
-		pthread_mutex_lock(&run_yield);
+		late = timespec_diff(&now, &deadline);
+		us = late * 1e6;
+		for (b = 0; b < NUM_JITTER_BUCKETS - 1 && us >= jitter_bound[b]; ++b)
+			;
+		++jitter_hist[b];
 
-		capture_passive_mouse_input();
-		apply_thrust(1); /* keyboard & mouse motion */
-		process_motion(1); /* ship motion */
-		process_asteroid_motion(1);	/* ...and asteroid motion. Comment this out to browse the data set */
-		process_deleted_ast();
-		process_torpedo_motion(1);
-		process_torpedo_trails();
-		process_explosion();
-		process_dust();
-		process_shield();
-		process_sound();
-		++ticks;
+		/* this tick, plus every whole tick we are behind */
+		due = 1 + static_cast(unsigned long, late / dt);
+		if (due > MAX_CATCHUP_TICKS) {
+			dropped_ticks += due - MAX_CATCHUP_TICKS;
+			due = MAX_CATCHUP_TICKS;
+			deadline = now;
+		} else {
+			timespec_add(&deadline, (due - 1) * dt);
+		}
+		late_ticks   += due - 1;
+		window_ticks += due;
+		while (due-- > 0) /* due is now the ticks after this one */
+			run_tick(deadline.tv_sec + deadline.tv_nsec / 1e9 -
+			         due * dt);
 
-		pthread_mutex_unlock(&run_yield);
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		if (timespec_diff(&now, &window) >= 1) {
+			achieved_tps = window_ticks / timespec_diff(&now, &window);
+			run_ticks   += window_ticks;
+			run_time    += timespec_diff(&now, &window);
+			window_ticks = 0;
+			window       = now;
+		}
 	}
 
 	return NULL;
 }
 
+/* Run one tick, which was due at the given time */
+static void run_tick(double due)
+{
+	struct timespec start, locked, end;
+	double stall;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	pthread_mutex_lock(&run_yield);
+	clock_gettime(CLOCK_MONOTONIC, &locked);
+	stall = timespec_diff(&locked, &start);
+	stall_time += stall;
+	if (stall > stall_max)
+		stall_max = stall;
+
+	process_input();
+	capture_passive_mouse_input();
+	run_sim_tick();
+	process_dust();
+	process_wind_parts();
+	process_sound();
+	publish_snapshot(due);
+
+	pthread_mutex_unlock(&run_yield);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	if (timespec_diff(&end, &start) > dt)
+		++overrun_ticks;
+	return;
+}
+
+/* a - b in seconds */
+static double timespec_diff(const struct timespec *a,
+    const struct timespec *b)
+{
+	return (a->tv_sec - b->tv_sec) + (a->tv_nsec - b->tv_nsec) / 1e9;
+}
+
+static void timespec_add(struct timespec *t, double s)
+{
+	long ns = t->tv_nsec + static_cast(long, s * 1e9);
+
+	t->tv_sec  += ns / 1000000000;
+	t->tv_nsec  = ns % 1000000000;
+	return;
+}
+
+void print_frame_stats(void)
+{
+	unsigned int b;
+
+	printf("Sim thread: %.1f ticks/s achieved of %.0f, %lu late, "
+	       "%lu dropped, %lu overrun ticks\n",
+	       (run_time > 0) ? run_ticks / run_time : 0, tps,
+	       late_ticks, dropped_ticks, overrun_ticks);
+	printf("Wakeup jitter:");
+	for (b = 0; b < NUM_JITTER_BUCKETS - 1; ++b)
+		printf(" <%uus: %lu,", jitter_bound[b], jitter_hist[b]);
+	printf(" more: %lu\n", jitter_hist[b]);
+	printf("Sim thread stalls on run_yield: %.3f ms in all, longest "
+	       "%.0f us\n", stall_time * 1e3, stall_max * 1e6);
+	return;
+}
+
+/*
+ * Stress test: run the asteroid field for n ticks without a window and
+ * print the time per tick, e.g. "asteroids3D -num 10000 -bench 1000".
+ * The motion figure covers process_asteroid_motion() and
+ * process_deleted_ast(), the per-tick work that changes of the field layout
+ * are measured by; its 1-thread line at -num 1000, 10000 and 100000 is the
+ * figure to compare. The rock-rock stage is timed on its own so that its
+ * share is visible.
+ * The run is repeated from the same seed for 1 up to all threads of the
+ * worker pool, and the final fields are checksummed to show that the
+ * thread count does not change the outcome. Returns 0 if it did.
+ */
+int run_benchmark(unsigned int n)
+{
+	unsigned int threads, max_threads = set_active_workers(0);
+	unsigned long long sum, first_sum = 0;
+	double motion, first_motion = 0;
+	int same = 1;
+
+	for (threads = 1; threads <= max_threads; ++threads) {
+		set_active_workers(threads);
+		motion = bench_pass(n, &sum);
+		if (threads == 1) {
+			first_motion = motion;
+			first_sum    = sum;
+		}
+		printf("  %2u thread(s): %.2fx speedup of the motion stage, "
+		       "field checksum %016llx (%s)\n", threads,
+		       first_motion / motion, sum,
+		       (sum == first_sum) ? "identical" : "DIFFERS");
+		if (sum != first_sum)
+			same = 0;
+	}
+
+	print_collision_stats();
+	if (!same)
+		fprintf(stderr, "The thread count changed the outcome\n");
+	return same;
+}
+
+/* One benchmark run from BENCH_SEED. Prints the time per tick, returns that
+of the motion stage and stores a checksum of the final field in *sum. */
+static double bench_pass(unsigned int n, unsigned long long *sum)
+{
+	struct timespec t0, t1, t2;
+	double motion = 0, rocks = 0;
+	unsigned long hits = 0;
+	unsigned int i;
+
+	/* the LOD schedule goes by the tick count, so every pass starts
+	from tick 0 to run the same simulation */
+	ticks = 0;
+	rng_seed(BENCH_SEED);
+	rng_select(RNG_SIM);
+	reset_view();
+	vec_zero(&velocity);
+	init_asteroids();
+
+	for (i = 0; i < n; ++i) {
+		clock_gettime(CLOCK_MONOTONIC, &t0);
+		process_asteroid_motion(1);
+		process_deleted_ast();
+		clock_gettime(CLOCK_MONOTONIC, &t1);
+		if (optmap.rock_collision_flag)
+			hits += process_rock_collisions();
+		clock_gettime(CLOCK_MONOTONIC, &t2);
+
+		motion += (t1.tv_sec - t0.tv_sec) * 1e6 +
+		          (t1.tv_nsec - t0.tv_nsec) / 1e3;
+		rocks  += (t2.tv_sec - t1.tv_sec) * 1e6 +
+		          (t2.tv_nsec - t1.tv_nsec) / 1e3;
+		++ticks;
+	}
+
+	printf("%u asteroids, %u ticks: motion %.1f us/tick, "
+	       "rock collisions %.1f us/tick (%lu bounces)\n",
+	       afield.count, n, motion / n, rocks / n, hits);
+	*sum = field_checksum();
+	return motion;
+}
+
+/* FNV-1a over the positions, velocities and rotations of the field, as
+stored. The w member of a vector is not part of the state (nor initialized
+for new rocks), so only x, y and z are hashed. */
+static unsigned long long field_checksum(void)
+{
+	const unsigned char *b[3];
+	size_t len[3], k, j;
+	unsigned long long h = 0xcbf29ce484222325ULL;
+	unsigned int i;
+
+	len[0] = len[1] = 3 * sizeof(afield.pos->x);
+	len[2] = sizeof(int);
+	ast_foreach(i) {
+		b[0] = reinterpret_cast(const unsigned char *, &afield.pos[i].x);
+		b[1] = reinterpret_cast(const unsigned char *,
+		       &afield.velocity[i].x);
+		b[2] = reinterpret_cast(const unsigned char *, &afield.rot[i]);
+		for (k = 0; k < 3; ++k)
+			for (j = 0; j < len[k]; ++j) {
+				h ^= b[k][j];
+				h *= 0x100000001b3ULL;
+			}
+	}
+	return h;
+}
+
 void capture_passive_mouse_input(void)
 {
 	if (paused()) /* must continue to compute dt even if paused. HACK FIXME? */
@@ -23,6 +23,7 @@
  */
 
 #include <math.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -39,94 +40,314 @@
 // Maximum time to flicker the hud gauges after a collision
 #define MAX_HUD_FLICKER_TTL 5.0
 
+/* Edge length of a broadphase cell. This is the widest reach of any
+narrowphase test (ship vs. the largest rock), so everything that can collide
+with a point lies in the 3x3x3 cells around it. Two rocks never reach
+further than that either. */
+#define BP_CELL (SHIP_SZ + AST_RADIUS(NUM_AST_TYPES - 1))
+
+/* Farthest a torp's centre can be from a rock's centre on a hit */
+#define TORP_REACH (2 * TORP_RADIUS + AST_RADIUS(NUM_AST_TYPES - 1))
+
+/* Extra time (s) correct_positions() adds to the exit time */
+#define TOI_SLOP 1e-9
+
+/* The rock grid has the same cells, taken modulo RG_DIM along each axis.
+RG_DIM cells span more than the 2 * ABOUND the field is wrapped into, so
+distinct cells of the field never share a slot. */
+#define RG_BITS 5
+#define RG_DIM (1 << RG_BITS)
+#define RG_MASK (RG_DIM - 1)
+#define RG_CELLS (RG_DIM * RG_DIM * RG_DIM)
+#define RG_INDEX(x, y, z) (((x) & RG_MASK) | ((y) & RG_MASK) << RG_BITS | \
+	((z) & RG_MASK) << (2 * RG_BITS))
+#define RG_BIT(c) (static_cast(uint64_t, 1) << ((c) % 64)) // in rg_used[c / 64]
+
+static unsigned int bp_cell(double);
+static unsigned int bp_hash(const Vector *, int, int, int);
+static void bp_link(unsigned int, unsigned int);
+static unsigned int bp_query(const Vector *, unsigned int);
+static void bp_unlink(unsigned int);
+static unsigned int bounce_rocks(unsigned int, unsigned int, unsigned int,
+    unsigned int);
+static void build_rock_grid(void);
+static void check_collision(unsigned int);
+static int compare_indices(const void *, const void *);
+static void elastic_collision(Vector *, double, Vector *, double);
+static int ship_hit(const Vector *, const Vector *, double);
+static int sphere_toi(const Vector *, const Vector *, double, double *,
+    double *);
+static int torp_hit(const Torpedo *, const Vector *, double);
+static unsigned int torp_query(const Torpedo *, unsigned int);
+
+/* Spatial hash of the asteroid field. Each bucket is a doubly linked list
+of asteroid indices; broadphase_move() relinks a rock only when it moves to
+another bucket, and broadphase_remove() follows ast_remove(). Asteroids
+[0, bp_count) are in the hash, newer ones are added when they first move or
+by process_collisions(), whichever comes first. All arrays are sized from the asteroid pool in init_broadphase(). */
+static unsigned int bp_mask;          // number of buckets - 1
+static unsigned int bp_count;         // asteroids in the hash
+static int *bp_head;                  // first asteroid of each bucket
+static int *bp_next, *bp_prev;        // neighbours in the bucket's list
+static unsigned int *bp_bucket;       // bucket of each asteroid
+static unsigned int *bp_cand;         // candidates gathered by bp_query()
+static unsigned int *bp_stamp;        // bp_epoch if already a candidate
+static unsigned int bp_epoch;
+
+/* Rock grid, rebuilt by build_rock_grid() for process_rock_collisions().
+The rocks of cell c are the rg_count[c] entries from rg_start[c] on of the
+rg_cell, rg_index, rg_pos and rg_rad arrays. Only the cells marked in
+rg_used are set up; the count of every other cell is 0 at all times. */
+static unsigned int rg_start[RG_CELLS];
+static unsigned int rg_count[RG_CELLS];
+static uint64_t rg_used[RG_CELLS / 64]; // bit c is set if cell c has rocks
+static unsigned int *rg_key;          // cell of each asteroid
+static unsigned int *rg_cell;         // cell of each entry
+static unsigned int *rg_index;        // asteroid of each entry
+static Vector *rg_pos;                // copy of the asteroid's position
+static double *rg_rad;                // asteroid radius
+
+// Time to end hud gauge flicker, intially off. Turned on after a collision.
+double flicker_hud_ttl = 0;
+
+// Collision warning gauge: also 0 = off, 1 = on
+int cwg_rear, cwg_above, cwg_below, cwg_left, cwg_right;
+
+/* Statistics for print_collision_stats() */
+static unsigned long toi_swept_hits;  // ship hits only found by the sweep
+static unsigned long toi_corrections; // rocks moved by correct_positions()
+static unsigned long toi_steps_saved; // 0.01 s steps the old loop would take
+
 //-----------------------------------------------------------------------------
-void process_deleted_ast(void)
+static int compare_indices(const void *pa, const void *pb)
 {
-	Node *current = NULL, *temp = NULL;
-	int i, j;
+	unsigned int a = *static_cast(const unsigned int *, pa);
+	unsigned int b = *static_cast(const unsigned int *, pb);
+	return (a > b) - (a < b);
+}
 
-	// delete any nodes in the delete_next_ast array
-	for (i = 0; i < MAX_TORPS; ++i) {
-		if (delete_next_ast[i] == NULL)
-			continue;
+int init_broadphase(void)
+{
+	unsigned int n = afield.capacity, nb = 64, i;
+
+	/* about one bucket per asteroid keeps the lists short */
+	while (nb < n)
+		nb <<= 1;
+	bp_mask = nb - 1;
+
+	free(bp_head);
+	free(bp_next);
+	free(bp_prev);
+	free(bp_bucket);
+	free(bp_cand);
+	free(bp_stamp);
+	free(rg_key);
+	free(rg_cell);
+	free(rg_index);
+	free(rg_pos);
+	free(rg_rad);
+
+	bp_head   = malloc(nb * sizeof(*bp_head));
+	bp_next   = malloc(n * sizeof(*bp_next));
+	bp_prev   = malloc(n * sizeof(*bp_prev));
+	bp_bucket = malloc(n * sizeof(*bp_bucket));
+	bp_cand   = malloc(n * sizeof(*bp_cand));
+	bp_stamp  = calloc(n, sizeof(*bp_stamp));
+	rg_key    = malloc(n * sizeof(*rg_key));
+	rg_cell   = malloc(n * sizeof(*rg_cell));
+	rg_index  = malloc(n * sizeof(*rg_index));
+	rg_pos    = malloc(n * sizeof(*rg_pos));
+	rg_rad    = malloc(n * sizeof(*rg_rad));
+	if (bp_head == NULL || bp_next == NULL || bp_prev == NULL ||
+	    bp_bucket == NULL || bp_cand == NULL || bp_stamp == NULL ||
+	    rg_key == NULL || rg_cell == NULL || rg_index == NULL ||
+	    rg_pos == NULL || rg_rad == NULL)
+		return 0;
+
+	for (i = 0; i < nb; ++i)
+		bp_head[i] = -1;
+	bp_count = 0;
+	bp_epoch = 0;
+	return 1;
+}
 
-		current = delete_next_ast[i]->next;
-
-		/* Why this inner loop? Two checks are performed.
-		 *
-		 * First: if the asteroid which is about to be deleted (current) is
-		 * also somewhere in the delete_next_ast list as a pointer to a second
-		 * asteroid to be deleted, then, of course there's a problem. When it
-		 * comes time to delete the second asteroid, the pointer to it will
-		 * have disappeared. To fix this, I set the pointer to the second
-		 * asteroid to be what it should be. Namely, the pointer to the
-		 * asteroid being deleted. A diagram deleting two asteroids in a row is
-		 * very helpful to visualize this.
-		 *
-		 * Second: In some circumstances an asteroid may get on the list to be
-		 * deleted twice. Say, if by chance two torps hit the asteroid
-		 * simultaniously. If this occurs, then the first deletion will be
-		 * fine, but of course the second deletion will fail. So to prevent
-		 * this, I check the list for duplicates, and if I find one, set the
-		 * duplicate to NULL so that I don't attempt to delete the asteroid
-		 * twice.
-		 */
-		for (j = i + 1; j < MAX_TORPS; ++j) {
-			if (current == delete_next_ast[j])
-				delete_next_ast[j] = delete_next_ast[i];
-			if (delete_next_ast[i] == delete_next_ast[j])
-				delete_next_ast[j] = NULL;
+/* Cell coordinate along one axis: floor(x / BP_CELL), wrapped to 32 bits */
+static unsigned int bp_cell(double x)
+{
+	static const double k = 1.0 / BP_CELL;
+	long long c = static_cast(long long, x * k);
+
+	return c - (x * k < c);
+}
+
+/* Bucket of the cell containing p, offset by (dx, dy, dz) cells */
+static unsigned int bp_hash(const Vector *p, int dx, int dy, int dz)
+{
+	unsigned int x = bp_cell(p->x) + dx;
+	unsigned int y = bp_cell(p->y) + dy;
+	unsigned int z = bp_cell(p->z) + dz;
+
+	return (x * 73856093U ^ y * 19349663U ^ z * 83492791U) & bp_mask;
+}
+
+static void bp_link(unsigned int n, unsigned int b)
+{
+	bp_bucket[n] = b;
+	bp_prev[n]   = -1;
+	bp_next[n]   = bp_head[b];
+	if (bp_head[b] >= 0)
+		bp_prev[bp_head[b]] = n;
+	bp_head[b] = n;
+	return;
+}
+
+static void bp_unlink(unsigned int n)
+{
+	if (bp_prev[n] >= 0)
+		bp_next[bp_prev[n]] = bp_next[n];
+	else
+		bp_head[bp_bucket[n]] = bp_next[n];
+	if (bp_next[n] >= 0)
+		bp_prev[bp_next[n]] = bp_prev[n];
+	return;
+}
+
+/* Called by process_asteroid_motion() after asteroid n has moved. Rocks
+drift much less than a cell per tick, so almost all of them stay put. */
+void broadphase_move(unsigned int n)
+{
+	unsigned int b;
+	Vector p;
+
+	ast_pos(&p, n);
+	b = bp_hash(&p, 0, 0, 0);
+
+	if (n >= bp_count) {
+		bp_link(n, b);
+		bp_count = n + 1;
+	} else if (b != bp_bucket[n]) {
+		bp_unlink(n);
+		bp_link(n, b);
+	}
+	return;
+}
+
+/* Called by ast_remove() before asteroid n is overwritten by the last one */
+void broadphase_remove(unsigned int n)
+{
+	unsigned int last = afield.count - 1, b;
+	Vector p;
+
+	if (n < bp_count) {
+		bp_unlink(n);
+		if (n != last) {
+			if (last < bp_count) {
+				b = bp_bucket[last];
+				bp_unlink(last);
+			} else {
+				ast_pos(&p, last);
+				b = bp_hash(&p, 0, 0, 0);
+			}
+			bp_link(n, b);
 		}
+	}
+	if (last < bp_count)
+		--bp_count;
+	return;
+}
+
+/* Append every asteroid in the 27 cells around p to bp_cand, starting at
+entry num, and return the new number of candidates. */
+static unsigned int bp_query(const Vector *p, unsigned int num)
+{
+	int dx, dy, dz, n;
+
+	for (dx = -1; dx <= 1; ++dx)
+		for (dy = -1; dy <= 1; ++dy)
+			for (dz = -1; dz <= 1; ++dz) {
+				n = bp_head[bp_hash(p, dx, dy, dz)];
+				for (; n >= 0; n = bp_next[n]) {
+					if (bp_stamp[n] == bp_epoch)
+						continue;
+					bp_stamp[n] = bp_epoch;
+					bp_cand[num++] = n;
+				}
+			}
 
-		// if I'm deleting the tail, I have to reassign it
-		if (current->next == NULL)
-			al_tail = delete_next_ast[i];
+	return num;
+}
+
+/*
+ * Run the ship and torpedo collision tests for the whole field.
+ *
+ * Only the asteroids near the ship or a live torp can pass the narrowphase
+ * in check_collision(), so those are looked up in the spatial hash instead
+ * of testing every rock. The candidates are tested in ascending index order,
+ * and fragments spawned by hits are tested after them. That is exactly the
+ * order of the old one-rock-at-a-time walk, so the ship's velocity, the torp
+ * kills and the score come out the same.
+ */
+void process_collisions(void)
+{
+	unsigned int i, num, first_fragment = afield.count;
+	Vector p;
 
-		temp = current;
-		delete_next_ast[i]->next = current->next;
-		free(temp);
+	/* only asteroids that have not moved yet are missing */
+	for (; bp_count < afield.count; ++bp_count) {
+		ast_pos(&p, bp_count);
+		bp_link(bp_count, bp_hash(&p, 0, 0, 0));
 	}
+	++bp_epoch;
+
+	num = bp_query(&pos, 0);
+	for (i = 0; i < MAX_TORPS; ++i)
+		if (torp[i].ttl != 0 && torp[i].in_flight_flag)
+			num = torp_query(&torp[i], num);
+
+	qsort(bp_cand, num, sizeof(*bp_cand), compare_indices);
+	for (i = 0; i < num; ++i)
+		check_collision(bp_cand[i]);
+
+	/* The fragments of this tick's hits are spawned together. They sit
+	where their parent was hit, maybe in reach of another torp; there are
+	only a few, so just test them all, and their own fragments in turn. */
+	i = first_fragment;
+	while (spawn_new_asteroids() > 0 || i < afield.count)
+		for (; i < afield.count; ++i)
+			check_collision(i);
 
-	// re-initialize the delete_next_ast array for next frame
-	memset(delete_next_ast, 0, sizeof(Node *) * MAX_TORPS);
 	return;
 }
 
-void check_collision(Node *previous)
+static void check_collision(unsigned int n)
 {
-	Node *current = NULL;
-	double distance, collision_dist;
-	int i , j;
-	Vector temp1, temp2;
-	Asteroid *cv;
+	double collision_dist, radius;
+	Vector p, v;
+	int i, type;
 
-	current = previous->next;
-	cv      = &current->rock;
+	type   = afield.type[n];
+	radius = AST_RADIUS(type);
+	ast_pos(&p, n);
+	ast_vel(&v, n);
 
 	/* code to check for asteroid and ship collisions */
-	distance = vec_dist(&cv->pos, &pos);
-	collision_dist = SHIP_SZ + cv->radius;
+	collision_dist = SHIP_SZ + radius;
 
-	if (distance <= collision_dist) {
+	if (ship_hit(&p, &v, collision_dist)) {
 		/* if there is a collision then first run the collision "model"
 		 * if the "model" were any simpler then you'd just pass through things...
 		 */
-		apply_collision_v(&cv->velocity, cv->mass);
-
-		/* next, here's a hack to predict whether or not the asteroid
-		 * and the ship will still be inside their collision radius
-		 * in the next frame (dt). This could happen if distance < collision_dist
-		 * rather than distance = collision_dist.
-		 *
-		 * If turns out that they are, then run the correct_positions hack
-		 * to nudge ship & rock into the right spots.
-		 */
-		vec_addmul(&temp1, &pos, dt, &velocity);
-		vec_addmul(&temp2, &cv->pos, dt, &cv->velocity);
+		apply_collision_v(&v, AST_MASS(type));
 
-		if (vec_dist(&temp1, &temp2) < collision_dist)
-			correct_positions(&cv->velocity, &cv->pos,
-			                  collision_dist);
+		/* next, the asteroid and the ship may still be inside their
+		 * collision radius in the next frame (dt). This could happen
+		 * if distance < collision_dist rather than distance =
+		 * collision_dist. If so, correct_positions() nudges the rock
+		 * out.
+		 */
+		correct_positions(&v, &p, collision_dist);
+		ast_set_vel(n, &v);
+		ast_set_pos(n, &p);
 
 		/* set up the shield graphics */
 		shield_activated_flag = 1;
@@ -146,37 +367,223 @@ void check_collision(Node *previous)
 		if (t->ttl == 0 || !t->in_flight_flag)
 			continue;
 
-		distance = vec_dist(&cv->pos, &t->pos);
-		collision_dist = 2 * TORP_RADIUS + cv->radius;
-
-		if (distance > collision_dist)
+		collision_dist = 2 * TORP_RADIUS + radius;
+		if (!torp_hit(t, &p, collision_dist))
 			continue;
 
 		activate_explosion(&t->pos);
-		play_sound(SOUND_ASTEROID_HIT, cv->type);
+		play_sound(SOUND_ASTEROID_HIT, type);
 
-		if (cv->mass > MIN_AST_MASS)
-			add_new_asteroids(&cv->pos, cv->type);
+		if (AST_MASS(type) > MIN_AST_MASS)
+			queue_new_asteroids(&p, type);
 
 		t->ttl = 0; // this flag kills the torp in process_torpedo_motion()
 
-		/* Find an empty slot in delete_next_ast at point it at the
-		asteroid prior to the one to be deleted. */
-		for (j = 0; j < MAX_TORPS; ++j)
-			if (delete_next_ast[j] == NULL) {
-				delete_next_ast[j] = previous;
-				break;
-			}
+		/* Queue the asteroid for deletion at the end of the tick */
+		ast_kill(n);
 
-		if (is_targeted(&current->rock))
+		if (is_targeted(n))
 			drop_target();
 
-		add_rock_to_score(&current->rock);
+		add_rock_to_score(&v, type);
 	} /* end TORP for loop */
 
 	return;
 }
 
+/*
+ * Gather the candidates for torp t. Its whole path over the last tick is
+ * tested, so the cells around points spaced along that path are looked up:
+ * every point of the path is within half a spacing of one of them, and
+ * anything a torp can hit there is within BP_CELL of it.
+ */
+static unsigned int torp_query(const Torpedo *t, unsigned int num)
+{
+	static const double spacing = 2 * (BP_CELL - TORP_REACH);
+	unsigned int k, samples;
+	Vector d, p;
+
+	vec_sub(&d, &t->pos, &t->prev_pos);
+	samples = ceil(vec_length(&d) / spacing);
+	if (samples == 0)
+		return bp_query(&t->pos, num);
+
+	/* midpoints of equal pieces of the path */
+	for (k = 0; k < samples; ++k) {
+		vec_addmul(&p, &t->prev_pos, (k + 0.5) / samples, &d);
+		num = bp_query(&p, num);
+	}
+	return num;
+}
+
+/*
+ * Did torp t pass within collision_dist of the rock at rock_p during the
+ * last tick? The closest point to the rock on the segment from prev_pos to
+ * pos is tested, not just the end point: a fast torp (low tps, or a fast
+ * ship) moves further than a small rock is wide in one tick.
+ */
+static int torp_hit(const Torpedo *t, const Vector *rock_p,
+    double collision_dist)
+{
+	Vector d, a;
+	double dd, k = 1;
+
+	vec_sub(&d, &t->pos, &t->prev_pos);
+	vec_sub(&a, &t->prev_pos, rock_p);
+	dd = vec_dot(&d, &d);
+	if (dd > 0) {
+		k = -vec_dot(&a, &d) / dd;
+		if (k < 0)
+			k = 0;
+		else if (k > 1)
+			k = 1;
+	}
+
+	vec_addmul(&a, &a, k, &d);
+	return vec_dot(&a, &a) <= collision_dist * collision_dist;
+}
+
+/*
+ * Does asteroid n hit the ship this tick? Either they overlap already, or
+ * the relative motion closes the gap before dt is up, which a test at the
+ * end of the tick alone would miss for a fast ship or rock.
+ */
+static int ship_hit(const Vector *rock_p, const Vector *rock_v,
+    double collision_dist)
+{
+	Vector rel_p, rel_v;
+	double t0, t1;
+
+	vec_sub(&rel_p, rock_p, &pos);
+	if (vec_dot(&rel_p, &rel_p) <= collision_dist * collision_dist)
+		return 1;
+
+	vec_sub(&rel_v, rock_v, &velocity);
+	if (!sphere_toi(&rel_p, &rel_v, collision_dist, &t0, &t1) ||
+	    t0 < 0 || t0 > dt)
+		return 0;
+
+	++toi_swept_hits;
+	return 1;
+}
+
+/*
+ * Bounce the asteroids off each other and return the number of bounces.
+ *
+ * The field is counting-sorted into the rock grid, with positions and radii
+ * copied next to each other in cell order, so each cell is a short run of
+ * consecutive entries. Only the occupied cells are counted and summed up,
+ * so the cost goes with the number of rocks, not with the size of the grid.
+ * Every cell is tested against itself and the 13 neighbours "after" it,
+ * which sees each pair of neighbouring cells once.
+ * Rocks only bounce while they are closing in, so overlapping rocks do not
+ * stick together.
+ */
+unsigned int process_rock_collisions(void)
+{
+	static const int fwd[13][3] = {
+		{0, 0, 1}, {0, 1, -1}, {0, 1, 0}, {0, 1, 1},
+		{1, -1, -1}, {1, -1, 0}, {1, -1, 1}, {1, 0, -1}, {1, 0, 0},
+		{1, 0, 1}, {1, 1, -1}, {1, 1, 0}, {1, 1, 1},
+	};
+	unsigned int a, b, c, k, x, y, z, hits = 0;
+
+	build_rock_grid();
+
+	for (a = 0; a < afield.count; a = b) {
+		c = rg_cell[a];
+		b = a + rg_count[c];
+		hits += bounce_rocks(a, b, a, b);
+
+		x = c & RG_MASK;
+		y = (c >> RG_BITS) & RG_MASK;
+		z = c >> (2 * RG_BITS);
+		for (k = 0; k < sizeof(fwd) / sizeof(*fwd); ++k) {
+			c = RG_INDEX(x + fwd[k][0], y + fwd[k][1], z + fwd[k][2]);
+			if (rg_used[c / 64] & RG_BIT(c))
+				hits += bounce_rocks(a, b, rg_start[c],
+				        rg_start[c] + rg_count[c]);
+		}
+	}
+
+	/* leave the grid empty for the next build */
+	for (a = 0; a < afield.count; a = b) {
+		c = rg_cell[a];
+		b = a + rg_count[c];
+		rg_count[c] = 0;
+	}
+	memset(rg_used, 0, sizeof(rg_used));
+	return hits;
+}
+
+static void build_rock_grid(void)
+{
+	unsigned int i, k, c, w, end = 0;
+	uint64_t bits;
+	Vector p;
+
+	ast_foreach(i) {
+		ast_pos(&p, i);
+		rg_key[i] = c = RG_INDEX(bp_cell(p.x), bp_cell(p.y),
+		            bp_cell(p.z));
+		++rg_count[c];
+		rg_used[c / 64] |= RG_BIT(c);
+	}
+
+	/* the occupied cells in ascending order */
+	for (w = 0; w < RG_CELLS / 64; ++w)
+		for (bits = rg_used[w]; bits != 0; bits &= bits - 1) {
+			c = 64 * w + __builtin_ctzll(bits);
+			end += rg_count[c];
+			rg_start[c] = end;
+		}
+
+	/* rg_start[c] is the end of cell c now, and its start after filling */
+	for (i = afield.count; i-- > 0; ) {
+		c = rg_key[i];
+		k = --rg_start[c];
+		rg_cell[k]  = c;
+		rg_index[k] = i;
+		ast_pos(&rg_pos[k], i);
+		rg_rad[k]   = AST_RADIUS(afield.type[i]);
+	}
+	return;
+}
+
+/* Bounce the rocks of grid entries [a0, a1) off those of [b0, b1). If both
+ranges are the same cell, each pair is taken once. */
+static unsigned int bounce_rocks(unsigned int a0, unsigned int a1,
+    unsigned int b0, unsigned int b1)
+{
+	unsigned int a, b, i, j, hits = 0;
+	double rsum;
+	Vector d, dv, vi, vj;
+
+	for (a = a0; a < a1; ++a)
+		for (b = (a0 == b0) ? a + 1 : b0; b < b1; ++b) {
+			vec_sub(&d, &rg_pos[b], &rg_pos[a]);
+			rsum = rg_rad[a] + rg_rad[b];
+			if (vec_dot(&d, &d) > rsum * rsum)
+				continue;
+
+			i = rg_index[a];
+			j = rg_index[b];
+			ast_vel(&vi, i);
+			ast_vel(&vj, j);
+			vec_sub(&dv, &vj, &vi);
+			if (vec_dot(&d, &dv) >= 0)
+				continue;
+
+			elastic_collision(&vi, AST_MASS(afield.type[i]),
+			                  &vj, AST_MASS(afield.type[j]));
+			ast_set_vel(i, &vi);
+			ast_set_vel(j, &vj);
+			++hits;
+		}
+
+	return hits;
+}
+
 /*
  * This function uses a very simple collision model
  *
@@ -215,66 +622,167 @@ void check_collision(Node *previous)
  *    V(bf) = V(ai) - V(bi)  + V(af)
  */
 
-/* body "a" is the ship, and body "b" is the asteroid */
-
-void apply_collision_v(Vector *v, int mass)
+static void elastic_collision(Vector *va, double ma, Vector *vb, double mb)
 {
-	double ast_mass = mass, ship_mass = SHIP_MASS, k;
-	Vector temp = velocity;
+	Vector temp = *va;
+	double k;
 
 	/* V(af)  = ( M(a)V(ai) + 2*M(b)*V(bi) - M(b)V(ai)  )/( M(a) + M(b) ) */
 
-	k = 1.0 / (ast_mass + ship_mass);
-	velocity.x = k * (ship_mass * velocity.x + 2 * ast_mass * v->x -
-	             ast_mass * velocity.x);
-	velocity.y = k * (ship_mass * velocity.y + 2 * ast_mass * v->y -
-	             ast_mass * velocity.y);
-	velocity.z = k * (ship_mass * velocity.z + 2 * ast_mass * v->z -
-	             ast_mass *velocity.z);
+	k = 1.0 / (mb + ma);
+	va->x = k * (ma * va->x + 2 * mb * vb->x - mb * va->x);
+	va->y = k * (ma * va->y + 2 * mb * vb->y - mb * va->y);
+	va->z = k * (ma * va->z + 2 * mb * vb->z - mb * va->z);
 
-	/*  adjust the asteroid's vector */
+	/*  adjust the vector of body "b" */
  	/*  V(bf) = V(ai) - V(bi)  + V(af) */
 
-	v->x = temp.x - v->x + velocity.x;
-	v->y = temp.y - v->y + velocity.y;
-	v->z = temp.z - v->z + velocity.z;
+	vb->x = temp.x - vb->x + va->x;
+	vb->y = temp.y - vb->y + va->y;
+	vb->z = temp.z - vb->z + va->z;
+	return;
+}
+
+/* body "a" is the ship, and body "b" is the asteroid */
+
+void apply_collision_v(Vector *v, int mass)
+{
+	elastic_collision(&velocity, SHIP_MASS, v, mass);
 
 	/* now reduce the shield sensibly */
-	shield_strength -= ast_mass * vec_length(&velocity);
+	shield_strength -= mass * vec_length(&velocity);
 	return;
 }
 
 /* if the asteroid and the ship collide and the distance between them is less
  * than it should be ( i.e. they have passed into each other )
- * I need to correct the position of the asteroid and the ship so that
- * they are exactly the right distance from one another before I apply the
- * collision. If I don't, they will hit multiple times.
+ * I need to correct the position of the asteroid so that they are no longer
+ * inside each other after the next tick. If I don't, they will hit multiple
+ * times.
  *
- * This routine is a rather bad hack. I Basically, the premise is that rather
- * than thinking up some clever mathematical solution, I simply ride the vectors
- * backward from their current positions until I get "close" to the correct one,
- * and then I use that.
+ * The asteroid is ridden along its vector until it leaves the collision
+ * radius around where the ship will be after the tick. This used to be done
+ * by stepping 0.01 s at a time; sphere_toi() gives the exit time directly.
+ * We'll leave the ship untouched, though its easy to move it. The graphics
+ * seem to be smoother if only the asteroid is nudged.
  */
 void correct_positions(Vector *rock_v, Vector *rock_p, double distance)
 {
-	Vector cand_a, cand_s; /* candidate positions for the moment of impact */
-	double k;
+	Vector ship_p, rel;
+	double t0, t1, len;
+
+	vec_addmul(&ship_p, &pos, dt, &velocity);
+	vec_sub(&rel, rock_p, &ship_p);
+
+	if (vec_dot(rock_v, rock_v) == 0) {
+		/* a resting rock never rides out, push it straight out instead */
+		len = vec_length(&rel);
+		if (len < distance && len > 0)
+			vec_addmul(rock_p, &ship_p, distance / len, &rel);
+		return;
+	}
 
-	/* these are the future positions of the asteroid and ship */
-	vec_addmul(&cand_s, &pos, dt, &velocity);
-	vec_addmul(&cand_a, rock_p, dt, rock_v);
-	cand_s.w = 0;
-	cand_a.w = 0;
+	/* only if still inside after the tick */
+	if (!sphere_toi(&rel, rock_v, distance, &t0, &t1) ||
+	    t0 >= dt || t1 <= dt)
+		return;
 
-	/* now just nudge the asteroid so that the future distance is outside the
-	 * collision radius. We'll leave the ship untouched, though its easy to move it.
-	 * The graphics seem to be smoother if only the asteroid is nudged.
-	 */
-	k = dt;
-	while (vec_dist(&cand_s, &cand_a) < distance) {
-		k += 0.01;
-		vec_addmul(&cand_a, rock_p, k, rock_v);
+	/* a hair past t1, so rounding cannot leave it just inside */
+	vec_addmul(rock_p, rock_p, t1 + TOI_SLOP, rock_v);
+	++toi_corrections;
+	toi_steps_saved += ceil((t1 - dt) / 0.01);
+	return;
+}
+
+/*
+ * Time of impact of two spheres. p and v are the position and velocity of
+ * one body relative to the other, and distance is the sum of their radii.
+ * They touch when |p + t v| = distance, a quadratic in t:
+ *
+ *   (v.v) t^2 + 2 (p.v) t + (p.p - distance^2) = 0
+ *
+ * Returns 0 if the spheres never touch, else the times they start and stop
+ * touching go to *t0 and *t1 (t0 <= t1, either may be in the past).
+ */
+static int sphere_toi(const Vector *p, const Vector *v, double distance,
+    double *t0, double *t1)
+{
+	double a = vec_dot(v, v), b = vec_dot(p, v);
+	double c = vec_dot(p, p) - distance * distance;
+	double disc = b * b - a * c, q;
+
+	if (a == 0 || disc < 0)
+		return 0;
+
+	/* the form without cancellation between -b and the root */
+	q = -(b + copysign(sqrt(disc), b));
+	if (q == 0) {
+		*t0 = *t1 = 0;
+		return 1;
 	}
-	*rock_p = cand_a;
+	*t0 = q / a;
+	*t1 = c / q;
+	if (*t0 > *t1) {
+		double t = *t0;
+		*t0 = *t1;
+		*t1 = t;
+	}
+	return 1;
+}
+
+void print_collision_stats(void)
+{
+	printf("Collisions: %lu swept ship hits, %lu position corrections, "
+	       "%lu stepping iterations saved\n", toi_swept_hits,
+	       toi_corrections, toi_steps_saved);
+	return;
+}
+
+unsigned int scan_for_collision_warning(const Vector *apos)
+{
+	Vector ast_pos;
+	double len, theta;
+	unsigned int dir = 0;
+
+	/* If the rock is "far away" then return: that's not useful info.
+	Process the distance at first, because more asteroids are far-away
+	than close ones. */
+	if (vec_dist(apos, &pos) > 12)
+		return 0;
+
+	/* then get a normalized asteroid vector */
+	vec_sub(&ast_pos, apos, &pos);
+	len = vec_length(&ast_pos);
+	vec_sdiv(&ast_pos, &ast_pos, len);
+
+	/* if the rock is in front of the ship then return: its not represented on the gauge */
+	theta = vec_dot(&zaxis, &ast_pos);
+	if (theta > 0 && acos(theta) * 180 / M_PI < 50)
+		return 0;
+
+	/* If I get here, there's a close rock. Now I have to determine
+	 * from which direction its coming, and set the apropriate CWG_* bit
+	 */
+	if (vec_dot(&zaxis, &ast_pos) < 0)
+		dir |= CWG_REAR;
+	if (vec_dot(&yaxis, &ast_pos) > 0)
+		dir |= CWG_ABOVE;
+	if (vec_dot(&yaxis, &ast_pos) < 0)
+		dir |= CWG_BELOW;
+	if (vec_dot(&xaxis, &ast_pos) < 0) /* NOTE: right handed rule!!! */
+		dir |= CWG_RIGHT;
+	if (vec_dot(&xaxis, &ast_pos) > 0)
+		dir |= CWG_LEFT;
+	return dir;
+}
+
+/* Light up the gauge for the CWG_* directions scanned this tick */
+void set_collision_warning(unsigned int dir)
+{
+	cwg_rear  = (dir & CWG_REAR)  != 0;
+	cwg_above = (dir & CWG_ABOVE) != 0;
+	cwg_below = (dir & CWG_BELOW) != 0;
+	cwg_left  = (dir & CWG_LEFT)  != 0;
+	cwg_right = (dir & CWG_RIGHT) != 0;
 	return;
 }
@@ -145,9 +145,9 @@ void draw_debug_axes(void)
 void draw_debug_grid(void)
 {
 	const double d = cubenet_width;
-	int x = static_cast(int, pos.x / d) * d,
-	    y = static_cast(int, pos.y / d) * d,
-	    z = static_cast(int, pos.z / d) * d;
+	int x = static_cast(int, snapshot->pos.x / d) * d,
+	    y = static_cast(int, snapshot->pos.y / d) * d,
+	    z = static_cast(int, snapshot->pos.z / d) * d;
 
 	glPushMatrix();
 		glTranslated(x, y, z);
@@ -43,6 +43,53 @@ extern "C" {
 #define NUM_AST_TYPES 6 /* number of different kinds of asteroids/display lists */
 #define MIN_AST_MASS 5.0
 #define AST_MASS_K 10.0
+#define AST_MASS(type)   (MIN_AST_MASS + AST_MASS_K * (type))
+#define AST_RADIUS(type) (static_cast(double, (type) + 1) / 2)
+
+/* Walk every live asteroid in the field, see asteroid.c */
+#define ast_foreach(i) for ((i) = 0; (i) < afield.count; ++(i))
+
+/* Upper limit on the threads in the worker pool, see workers.c */
+#define MAX_WORKERS 16
+
+/* Random number streams, see random.c */
+#define RNG_SIM         0 // the game world and what happens to it
+#define RNG_RENDER      1 // looks only, drawn by the main thread
+#define RNG_WORKER      2 // first of the MAX_WORKERS worker pool streams
+#define NUM_RNG_STREAMS (RNG_WORKER + MAX_WORKERS)
+
+/* Phases of a simulation tick, timed separately by run_sim_tick() */
+#define SIM_SHIP            0
+#define SIM_ASTEROIDS       1
+#define SIM_DELETION        2
+#define SIM_ROCK_COLLISIONS 3
+#define SIM_TORPEDOS        4
+#define SIM_EXPLOSIONS      5
+#define SIM_SHIELD          6
+#define NUM_SIM_PHASES      7
+
+/* Collision warning directions, as returned by scan_for_collision_warning() */
+#define CWG_REAR  (1 << 0)
+#define CWG_ABOVE (1 << 1)
+#define CWG_BELOW (1 << 2)
+#define CWG_LEFT  (1 << 3)
+#define CWG_RIGHT (1 << 4)
+
+/* Input event types, see input.c */
+#define INPUT_KEY    0 // a key was pressed, code is the key
+#define INPUT_BUTTON 1 // a mouse button was pressed, code is the button
+#define INPUT_MOTION 2 // the mouse pointer moved to x, y
+#define INPUT_RESIZE 3 // the window is now x by y pixels
+
+/* Input events that can wait for the sim thread, a power of two */
+#define INPUT_RING_SIZE 256
+
+/* Index of no asteroid, e.g. when a target search finds nothing */
+#define NO_TARGET -1
+
+/* A handle that never resolves, see structs.h */
+#define NO_HANDLE_INIT {~0U, 0}
+#define NO_HANDLE ((Handle)NO_HANDLE_INIT)
 
 /* Torpedos are the "bullets" in the game.
  * You can only fire a few at a time
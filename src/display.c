@@ -23,7 +23,6 @@
  */
 
 #include <GL/glut.h>
-#include <pthread.h>
 #include <stdio.h>
 #include "asteroids3D.h"
 #include "vecops.h"
@@ -37,22 +36,29 @@ static void draw_mouse_pos(void);
 static void draw_nebula_billboards(void);
 static void draw_shield(void);
 static void draw_sun(void);
+static void draw_torp_plasma(void);
 static void draw_torp_trails(void);
 static void draw_torps(void);
 
 static const float l2_pos[] = {0, 0, 0, 1};
 
 //-----------------------------------------------------------------------------
+/*
+ * Draw a frame. Everything comes from the newest snapshot the sim thread
+ * has published, see snapshot.c, so the sim is never held up by the GL
+ * calls and a frame always shows the state at the end of one tick.
+ */
 void display(void)
 {
+	static int first_frame = 1;
+
+	snapshot = acquire_snapshot();
+
 	/* do some error checking for each frame. */
 	glutReportErrors();
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 	glMatrixMode(GL_MODELVIEW);
-	glLoadIdentity();
-	gluLookAt(pos.x, pos.y, pos.z,
-	          pos.x + zaxis.x, pos.y + zaxis.y, pos.z + zaxis.z,
-	          yaxis.x, yaxis.y, yaxis.z);
+	glLoadMatrixd(snapshot->view);
 
 	if (optmap.antialias_flag)
 		glEnable(GL_LINE_SMOOTH);
@@ -76,71 +82,52 @@ void display(void)
 	glPopMatrix();
 
 	// Tracer light
-	if (tracer_light_flag)
+	if (snapshot->tracer_light_flag)
 		glEnable(GL_LIGHT2);
 	else
 		glDisable(GL_LIGHT2);
 
 	// Debugging optics
-	pthread_mutex_lock(&run_yield);
 	if (optmap.axes_flag) {
 		draw_debug_grid();
 		draw_debug_axes();
 	}
-	pthread_mutex_unlock(&run_yield);
 
 	// Sun and nebula textures
-	pthread_mutex_lock(&run_yield);
 	if (!optmap.nebula_texture_flag)
 		draw_sun();
 	else
 		draw_nebula_billboards();
-	pthread_mutex_unlock(&run_yield);
 
 	// Asteroids
-	pthread_mutex_lock(&run_yield);
 	draw_asteroids();
-	pthread_mutex_unlock(&run_yield);
 
 	// Background spacedust
-	pthread_mutex_lock(&run_yield);
 	if (optmap.draw_dust_flag)
 		draw_dust();
-	pthread_mutex_unlock(&run_yield);
 
 	// Explosions
-	pthread_mutex_lock(&run_yield);
-	if (explosions_active_flag)
+	if (snapshot->explosions_active_flag)
 		draw_explosions();
-	pthread_mutex_unlock(&run_yield);
 
 	// Torpedoes
-	pthread_mutex_lock(&run_yield);
-	if (torps_in_flight_flag)
+	if (snapshot->torps_in_flight_flag)
 		draw_torps();
-	pthread_mutex_unlock(&run_yield);
 
 	// Torpedo trails
-	pthread_mutex_lock(&run_yield);
 	draw_torp_trails();
-	pthread_mutex_unlock(&run_yield);
 
 	/* draw mouse position */
-	pthread_mutex_lock(&run_yield);
 	draw_mouse_pos();
-	pthread_mutex_unlock(&run_yield);
 
 	/* alpha blended shield farther than cross hair */
-	pthread_mutex_lock(&run_yield);
-	if (optmap.draw_shield_flag && shield_activated_flag)
+	if (snapshot->draw_shield_flag && snapshot->shield_activated_flag)
 		draw_shield();
-	pthread_mutex_unlock(&run_yield);
 
 	// Windshield particles
-	pthread_mutex_lock(&run_yield);
-	if (expl_winshield_particle_count > 0 && optmap.draw_shield_flag)
+	if (snapshot->expl_winshield_particle_count > 0 &&
+	    snapshot->draw_shield_flag)
 		draw_expl_winshield_particles();
-	pthread_mutex_unlock(&run_yield);
 
 	/*
 	 * alpha blended cross hair is drawn last so that,
@@ -148,62 +135,65 @@ void display(void)
 	 * into the crosshair. If you put it first, it appears
 	 * opaque, even though the alpha blending is on.
 	 */
-	pthread_mutex_lock(&run_yield);
 	if (draw_gauge())
 		draw_hud();
-	pthread_mutex_unlock(&run_yield);
 
 	// Lens flares
-	pthread_mutex_lock(&run_yield);
 	// First, the sun's lens flares
 	if (!optmap.nebula_texture_flag)
 		draw_sun_lensflares();
 	// Draw the torp flares
 	if (optmap.draw_torp_lensflare_flag)
 		draw_torp_lensflares();
-	pthread_mutex_unlock(&run_yield);
 
 	glutSwapBuffers();
+	if (first_frame) {
+		first_frame = 0;
+		print_startup_times();
+	}
 	return;
 }
 
-static void draw_asteroids(void)
+/* Load the modelview matrix for the eye's position and axes */
+void gl_load_view(void)
 {
-	const Node *current = NULL;
-	Vector temp;
+	double m[16];
 
-	current = al_head->next;
-	while (current != NULL) {
-		/* first off, cull any rock that's behind the ship */
-		vec_sub(&temp, &current->rock.pos, &pos);
+	view_matrix(m);
+	glMatrixMode(GL_MODELVIEW);
+	glLoadMatrixd(m);
+	return;
+}
 
-		/* cull the model if its behind us */
-		if (vec_dot(&temp, &zaxis) < 0) {
-			current = current->next;
-			continue;
-		}
+static void draw_asteroids(void)
+{
+	const SnapRock *r;
+	unsigned int i;
+
+	/* the rocks behind the ship were left out of the snapshot */
+	if (draw_instanced_asteroids(snapshot->rock, snapshot->num_rocks))
+		return;
+	for (i = 0; i < snapshot->num_rocks; ++i) {
+		r = &snapshot->rock[i];
 
 		/* well, then draw the rock */
 		glPushMatrix();
-		glTranslatef(current->rock.pos.x, current->rock.pos.y,
-		             current->rock.pos.z);
-		glRotatef(current->rock.rot, current->rock.rot_axis.x,
-		          current->rock.rot_axis.y, current->rock.rot_axis.z);
+		glTranslatef(r->pos[0], r->pos[1], r->pos[2]);
+		glRotatef(r->rot, r->rot_axis[0], r->rot_axis[1],
+		          r->rot_axis[2]);
 
 		if (optmap.texture_flag) {
 			glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE,
 			          GL_MODULATE);
-			glBindTexture(GL_TEXTURE_2D,
-			              ast_tex[current->rock.type]);
+			glBindTexture(GL_TEXTURE_2D, ast_tex[r->type]);
 		}
 
-		glCallList(ast_dl[current->rock.type]); /* oh yea, draw the rock */
+		glCallList(ast_dl[r->type]); /* oh yea, draw the rock */
 
 		if (optmap.texture_flag)
 			glBindTexture(GL_TEXTURE_2D, 0);
 
 		glPopMatrix();
-		current = current->next;
 	}
 	return;
 }
@@ -215,11 +205,11 @@ static void draw_torps(void)
 	int i;
 
 	for (i = 0; i < MAX_TORPS; ++i) {
-		if (!sorted_torp[i].in_flight_flag)
+		if (!snapshot->sorted_torp[i].in_flight_flag)
 			continue;
 
 		// draw the torp if its in flight
-		t = &sorted_torp[i];
+		t = &snapshot->sorted_torp[i];
 		glPushMatrix();
 		glTranslatef(t->pos.x, t->pos.y, t->pos.z);
 
@@ -230,7 +220,8 @@ static void draw_torps(void)
 			draw_torp_plasma();
 			glCallList(torp_dl);
 		} else {
-			calc_torp_billboard_rot(&t->pos, &x, &y);
+			calc_torp_billboard_rot(&snapshot->pos, &t->pos, &x,
+			    &y);
 			glRotatef(y, 0, 1, 0);
 			glRotatef(x, 1, 0, 0);
 			/* rotate the billboard about z BEFORE rotating it into
@@ -247,13 +238,43 @@ static void draw_torps(void)
 	return;
 }
 
-static void draw_shield(void)
+static void draw_torp_plasma(void)
 {
-	if (ticks > shield_ttl) {
-		shield_activated_flag = 0;
-		return;
+	float emit0[] = {1, 1, 1, 1}; /* torp material properties */
+	float ad0[]   = {0, 0, 0, 1};
+	int k;
+
+	glEnable(GL_BLEND);
+
+	for (k = 0; k < 20; ++k) { /* how about 20 plasma bolts for each torp */
+		/* use a random alpha component for each bolt */
+		ad0[3] = gen_rand_float(0, 1);
+
+		/* use random (and equal) values for red and green so bolts vary from blue to white */
+		emit0[0] = emit0[1] = gen_rand_float(0, 1);
+		glMaterialfv(GL_FRONT, GL_AMBIENT_AND_DIFFUSE, ad0);
+		glMaterialfv(GL_FRONT, GL_EMISSION, emit0);
+		glBegin(GL_LINES);
+		glVertex3f(0, 0, 0);
+
+		if (k % 7 == 0)
+			/* every once in a while draw a long plasma bolt */
+			glVertex3f(gen_rand_float(0, 2 * TORP_RADIUS) - TORP_RADIUS,
+			           gen_rand_float(0, 2 * TORP_RADIUS) - TORP_RADIUS,
+			           gen_rand_float(0, 2 * TORP_RADIUS) - TORP_RADIUS);
+		else
+			/* usually draw a short plasma bolt */
+			glVertex3f(gen_rand_float(0, TORP_RADIUS) - TORP_RADIUS / 2,
+			           gen_rand_float(0, TORP_RADIUS) - TORP_RADIUS / 2,
+			           gen_rand_float(0, TORP_RADIUS) - TORP_RADIUS / 2);
+		glEnd();
 	}
+	glDisable(GL_BLEND);
+	return;
+}
 
+static void draw_shield(void)
+{
 	glCallList(shield_dl);
 	return;
 }
@@ -261,7 +282,8 @@ static void draw_shield(void)
 static void draw_sun(void)
 {
 	glPushMatrix();
-	glTranslatef(pos.x, pos.y, pos.z); /* keep sun fixed wrt ship */
+	/* keep sun fixed wrt ship */
+	glTranslatef(snapshot->pos.x, snapshot->pos.y, snapshot->pos.z);
 	glCallList(sun_dl);
 	glPopMatrix();
 	return;
@@ -275,7 +297,7 @@ static void draw_explosions(void)
 	int i;
 
 	for (i = 0; i < MAX_BLASTS; ++i) {
-		e = &explosion[i];
+		e = &snapshot->explosion[i];
 		if (!e->is_active)
 			continue;
 
@@ -301,28 +323,36 @@ static void draw_hud(void)
 	char buf[64];
 	Vector result;
 
-	result.x = vec_dot(&xaxis, &velocity);
-	result.y = vec_dot(&yaxis, &velocity);
-	result.z = vec_dot(&zaxis, &velocity);
+	result.x = vec_dot(&snapshot->xaxis, &snapshot->velocity);
+	result.y = vec_dot(&snapshot->yaxis, &snapshot->velocity);
+	result.z = vec_dot(&snapshot->zaxis, &snapshot->velocity);
 
 	snprintf(buf, sizeof(buf), "velocity: %2.2f %2.2f %2.2f",
 	         result.x, result.y, result.z);
 	draw_text_in_color(-0.9, -0.9, buf, HUD_R,HUD_G,HUD_B,HUD_A) ;
 
 	snprintf(buf, sizeof(buf), "score: %u",
-	         static_cast(unsigned int, score * difficulty_multiplier));
+	         static_cast(unsigned int,
+	         snapshot->score * difficulty_multiplier));
 	draw_text_in_color(-0.9, 0.9, buf, HUD_R, HUD_G, HUD_B, HUD_A);
 
 	snprintf(buf, sizeof(buf), "asteroids left: %d",
-	         num_asteroids_on_scanner);
+	         snapshot->num_asteroids_on_scanner);
 	draw_text_in_color(0.5, 0.9, buf, HUD_R, HUD_G, HUD_B, HUD_A);
 
+	/* only shown while the sim thread cannot keep up */
+	if (snapshot->achieved_tps < 0.95 * tps) {
+		snprintf(buf, sizeof(buf), "sim: %.0f of %.0f ticks/s",
+		         snapshot->achieved_tps, tps);
+		draw_text_in_color(-0.9, 0.8, buf, HUD_R, HUD_G, HUD_B, HUD_A);
+	}
+
 	/* these should be drawn before the alpha blended gauges */
-	if (currently_targeted_asteroid != NULL) {
-		draw_lcs(&currently_targeted_asteroid->rock);
-		draw_steering_cue(&currently_targeted_asteroid->rock);
-		draw_target_vector(&currently_targeted_asteroid->rock);
-		draw_target_box(&currently_targeted_asteroid->rock);
+	if (snapshot->have_target) {
+		draw_lcs(&snapshot->target);
+		draw_steering_cue(&snapshot->target);
+		draw_target_vector(&snapshot->target);
+		draw_target_box(&snapshot->target);
 	}
 
 	if (optmap.crosshair_flag)
@@ -360,6 +390,7 @@ static void draw_dust(void)
 	static const float emit_on[]  = {1, 1, 1, 1};
 	static const float ad[]       = {0, 0, 0, 1};
 	static const float emit_off[] = {0, 0, 0, 1};
+	const Vector (*dp)[NUM_CHILD_DUST_PART] = snapshot->dust_part;
 	int i, j;
 
 	glMaterialfv(GL_FRONT, GL_EMISSION, emit_on);
@@ -369,13 +400,12 @@ static void draw_dust(void)
 	glPointSize(1);
 	glBegin(GL_POINTS);
 	for (i = 0; i < NUM_DUST_PART; ++i) {
-		glVertex3f(dust_part[i][0].x, dust_part[i][0].y,
-		           dust_part[i][0].z);
+		glVertex3f(dp[i][0].x, dp[i][0].y, dp[i][0].z);
 
 		for (j = 1; j < NUM_CHILD_DUST_PART; ++j)
-			glVertex3f(dust_part[i][0].x + dust_part[i][j].x,
-			           dust_part[i][0].y + dust_part[i][j].y,
-			           dust_part[i][0].z + dust_part[i][j].z);
+			glVertex3f(dp[i][0].x + dp[i][j].x,
+			           dp[i][0].y + dp[i][j].y,
+			           dp[i][0].z + dp[i][j].z);
 	}
 	glEnd();
 	glPopMatrix();
@@ -388,7 +418,8 @@ static void draw_nebula_billboards(void)
 	int i;
 
 	glPushMatrix();
-	glTranslatef(pos.x, pos.y, pos.z); /* keep billboards fixed wrt ship */
+	/* keep billboards fixed wrt ship */
+	glTranslatef(snapshot->pos.x, snapshot->pos.y, snapshot->pos.z);
 	for (i = 0; i < NUM_NEBULA_TEX; ++i)
 		glCallList(nebula_dl[i]);
 	glPopMatrix();
@@ -401,17 +432,12 @@ static void draw_expl_winshield_particles(void)
 	const WindPart *w;
 	int i, k;
 
-	secs = static_cast(double, ticks) / tps;
-	k = expl_winshield_particle_count * NUM_WP_PER_BLAST;
+	/* the particles are renewed by process_wind_parts() */
+	secs = static_cast(double, snapshot->ticks) / tps;
+	k = snapshot->expl_winshield_particle_count * NUM_WP_PER_BLAST;
 
 	for (i = 0; i < k; ++i) {
-		w = &winshield_particle[i];
-		if (w->t_end < secs) {
-			gen_rand_wind_part(&winshield_particle[i], secs);
-			// take the shield down a bit since a particle hit it.
-			shield_strength -= 1;
-		}
-
+		w = &snapshot->winshield_particle[i];
 		if (w->t_start > secs) /* not ready to display */
 			continue;
 
@@ -445,7 +471,7 @@ static void draw_torp_trails(void)
 	glMaterialfv(GL_FRONT, GL_EMISSION, emit_on);
 
 	for (i = 0; i < MAX_TORP_TRAILS; ++i) {
-		t = &torp_trail[i];
+		t = &snapshot->torp_trail[i];
 		if (!t->is_running_flag && !t->is_ending_flag)
 			continue;
 
@@ -22,32 +22,24 @@
  *  Monroeville, PA 15146
  */
 
-#include <GL/glut.h>
 #include <math.h>
 #include <string.h>
 #include "asteroids3D.h"
 #include "vecops.h"
 
-static void gen_rand_explosion_particles(int, int, double, int);
 static void init_explosion_data(void);
-static void init_explosion_dl(void);
-static void init_explosion_winshield_particle_dl(void);
 
 /* Explosion array, which is defined to be MAX_BLASTS > MAX_TORPS size since
 there may be more than MAX_TORPS number of simultanious explosions, since the
 explosions (currently) last longer then the torp ttl. */
 Blast explosion[MAX_BLASTS];
 int explosions_active_flag = 0; // are there explosions activated
-int expl_dl[NUM_BLAST_TYPES];
-int expl_winshield_particle_dl;
 int expl_winshield_particle_count = 0;
 
 //-----------------------------------------------------------------------------
 void init_explosions(void)
 {
 	init_explosion_data();
-	init_explosion_dl();
-	init_explosion_winshield_particle_dl();
 	return;
 }
 
@@ -86,6 +78,7 @@ void activate_explosion(const Vector *ppos)
 	explosion[i].ttl = BLAST_TTL * tps + ticks;
 	explosion[i].scalar = 1;
 	explosion[i].type = gen_rand_int(0, NUM_BLAST_TYPES - 1);
+	++explosion[i].generation;
 
 	explosions_active_flag = 1;
 	return;
@@ -121,76 +114,3 @@ void process_explosion(void)
 
 	return;
 }
-
-
-static void init_explosion_dl(void)
-{
-	int i;
-
-	for (i = 0; i < NUM_BLAST_TYPES; ++i) {
-		expl_dl[i] = glGenLists(1);
-		gen_rand_explosion_particles(15 + i, 15 + i, 0.5, expl_dl[i]);
-	}
-	return;
-}
-
-
-static void gen_rand_explosion_particles(int ps, int ts, double pert, int dl)
-{
-	double phi, theta;
-	int p_slices = ps;
-	int t_slices = ts;
-	double delta_p = M_PI / p_slices;
-	double delta_t = 2 * M_PI / t_slices;
-	int rows = p_slices - 1;
-	int cols = t_slices;
-	int i, j;
-	double q = pert;
-
-	/*
-	 * This is the same code that generates the randomly perturbed sphere which
-	 * I turned into an asteroid. What was that you said about applying the
-	 * same trick again and again, Dr. Wetzel ? :-)
-	 *
-	 */
-	glNewList(dl, GL_COMPILE);
-	glPointSize(1);
-	glBegin(GL_POINTS);
-
-	for (i = 0, phi = delta_p; i < rows; phi += delta_p, ++i) {
-		double sinphi = sin(phi), cosphi = cos(phi);
-
-		for (j = 0, theta = 0; j < cols; theta += delta_t, ++j)
-			glVertex3f(cos(theta) * sinphi + gen_rand_float(-q, q),
-			           sin(theta) * sinphi + gen_rand_float(-q, q),
-			           cosphi + gen_rand_float(-q, q));
-	}
-
-	glEnd();
-	glEndList();
-	return;
-}
-
-static void init_explosion_winshield_particle_dl(void)
-{
-	static const float emit_on[]  = {0.0, 0.6, 0.0, 1.0};
-	static const float emit_off[] = {0.0, 0.0, 0.0, 1.0};
-	static const float ad[]       = {0.0, 0.0, 0.0, 0.5};
-	double t;
-
-	expl_winshield_particle_dl = glGenLists(1);
-	glNewList(expl_winshield_particle_dl, GL_COMPILE);
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-	glMaterialfv(GL_FRONT, GL_AMBIENT_AND_DIFFUSE, ad);
-	glMaterialfv(GL_FRONT, GL_EMISSION, emit_on);
-	glBegin(GL_TRIANGLE_FAN);
-	glVertex3f(0, 0, 0);
-	for (t = 0; t < 2 * M_PI + M_PI / 10; t += M_PI / 10)
-		glVertex3f(0.01 * cos(t), 0.01 * sin(t), 0);
-	glEnd();
-	glMaterialfv(GL_FRONT, GL_EMISSION, emit_off);
-	glDisable(GL_BLEND);
-	glEndList();
-	return;
-}
@@ -33,12 +33,6 @@ static void init_collision_warning_gauge(void);
 static void init_crosshair(void);
 static void init_torp_gauge(void);
 
-// Time to end hud gauge flicker, intially off. Turned on after a collision.
-double flicker_hud_ttl = 0;
-
-// Collision warning gauge: also 0 = off, 1 = on
-int cwg_rear, cwg_above, cwg_below, cwg_left, cwg_right;
-
 static int torp_gauge_dl[2]; // Torp gauge dl: 0 = off, 1 = on
 static int cwg_rear_dl[2], cwg_above_dl[2], cwg_below_dl[2];
 static int cwg_left_dl[2], cwg_right_dl[2];
@@ -147,7 +141,7 @@ void draw_shield_gauge(void)
 	double str, left, right, mid;
 
 	/* str is the percentage shield strength */
-	str = static_cast(double, shield_strength) / MAX_SHIELD;
+	str = static_cast(double, snapshot->shield_strength) / MAX_SHIELD;
 
 	snprintf(buf, sizeof(buf), "shield: %2.2f%% ", str * 100);
 	draw_text_in_color(0.5, -0.9, buf, HUD_R, HUD_G, HUD_B, HUD_A);
@@ -388,73 +382,36 @@ void draw_collision_warning_gauge(void)
 	glPushMatrix();
 		glLoadIdentity();
 		glTranslatef(c.x, c.y, c.z);
-		glCallList(cwg_rear_dl[cwg_rear]);
+		glCallList(cwg_rear_dl[snapshot->cwg_rear]);
 	glPopMatrix();
 
 	glPushMatrix();
 		glLoadIdentity();
 		glTranslatef(c.x, c.y + dy, c.z);
-		glCallList(cwg_above_dl[cwg_above]);
+		glCallList(cwg_above_dl[snapshot->cwg_above]);
 	glPopMatrix();
 
 	glPushMatrix();
 		glLoadIdentity();
 		glTranslatef(c.x, c.y - dy, c.z);
-		glCallList(cwg_below_dl[cwg_below]);
+		glCallList(cwg_below_dl[snapshot->cwg_below]);
 	glPopMatrix();
 
 	glPushMatrix();
 		glLoadIdentity();
 		glTranslatef(c.x - dx, c.y, c.z);
-		glCallList(cwg_left_dl[cwg_left]);
+		glCallList(cwg_left_dl[snapshot->cwg_left]);
 	glPopMatrix();
 
 	glPushMatrix();
 		glLoadIdentity();
 		glTranslatef(c.x + dx, c.y, c.z);
-		glCallList(cwg_right_dl[cwg_right]);
+		glCallList(cwg_right_dl[snapshot->cwg_right]);
 	glPopMatrix();
 
 	return;
 }
 
-void scan_for_collision_warning(Asteroid *a)
-{
-	Vector ast_pos;
-	double len, theta;
-
-	/* first get a normalized asteroid vector */
-	vec_sub(&ast_pos, &a->pos, &pos);
-	len = vec_length(&ast_pos);
-	vec_sdiv(&ast_pos, &ast_pos, len);
-
-	/* If the rock is "far away" then return: that's not useful info.
-	Process the distance at first, because more asteroids are far-away
-	than close ones. */
-	if (vec_dist(&a->pos, &pos) > 12)
-		return;
-
-	/* if the rock is in front of the ship then return: its not represented on the gauge */
-	theta = vec_dot(&zaxis, &ast_pos);
-	if (theta > 0 && acos(theta) * 180 / M_PI < 50)
-		return;
-
-	/* If I get here, there's a close rock. Now I have to determine
-	 * from which direction its coming, and set the apropriate cwg_* flag
-	 */
-	if (vec_dot(&zaxis, &ast_pos) < 0)
-		cwg_rear = 1;
-	if (vec_dot(&yaxis, &ast_pos) > 0)
-		cwg_above = 1;
-	if (vec_dot(&yaxis, &ast_pos) < 0)
-		cwg_below = 1;
-	if (vec_dot(&xaxis, &ast_pos) < 0) /* NOTE: right handed rule!!! */
-		cwg_right = 1;
-	if (vec_dot(&xaxis, &ast_pos) > 0)
-		cwg_left = 1;
-	return;
-}
-
 /* return 1 to draw the gauge, and 0 to not draw it */
 int draw_gauge(void)
 {
@@ -463,7 +420,8 @@ int draw_gauge(void)
 	- the time to flicker the hud has expired, or
 	- if I am flickering, then randomly draw the gauge
 	*/
-	return ticks > flicker_hud_ttl || gen_rand_int(0, tps) == 1;
+	return snapshot->ticks > snapshot->flicker_hud_ttl ||
+	       gen_rand_int(0, tps) == 1;
 }
 
 static void init_torp_gauge(void)
@@ -526,7 +484,7 @@ void draw_torp_gauge(void)
 		glPushMatrix();
 			glLoadIdentity();
 			glTranslatef(tg_pos.x, tg_pos.y, tg_pos.z);
-			glCallList(torp_gauge_dl[!torp[i].in_flight_flag]);
+			glCallList(torp_gauge_dl[!snapshot->torp[i].in_flight_flag]);
 		glPopMatrix();
 		tg_pos.y -= 0.1;
 	}
@@ -0,0 +1,202 @@
+/* Asteroids3D - a first person game of blowing up asteroids
+ * Copyright (C) 2000 Stuart Mark Pomerantz <smp [at] psc edu>
+ * Copyright © Jan Engelhardt <jengelh [at] gmx de>, 2003 - 2006
+ *
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  Stuart Pomerantz
+ *  3935 Stonecliffe drive
+ *  Monroeville, PA 15146
+ */
+
+/*
+ * Input from the GLUT callbacks to the sim thread. The callbacks run on
+the main thread and only post what they saw as a timestamped InputEvent;
+the sim thread drains the queue at the start of each tick and does what
+the events ask for, so the ship, the torps and the flags are only ever
+changed by the sim thread and nobody has to take a lock.
+ *
+ * The queue is a ring with one writer and one reader. The writer owns
+ring_head and the reader ring_tail; each reads the other's index with
+acquire and publishes its own with release, which is all the ordering the
+event slots need. Should the ring ever fill up, new events are dropped and
+counted.
+ */
+
+#include <GL/glut.h>
+#include <stdio.h>
+#include <time.h>
+#include "asteroids3D.h"
+
+static void apply_event(const InputEvent *);
+static void set_dead_zone(int, int);
+static void steer_by_pointer(int, int);
+
+static InputEvent ring[INPUT_RING_SIZE];
+static unsigned int ring_head = 0; // next slot to post to, main thread
+static unsigned int ring_tail = 0; // next slot to drain, sim thread
+
+/* Statistics, see print_input_stats() */
+static unsigned long dropped_events;  // main thread
+static unsigned long drained_events;  // sim thread
+static double latency_time, latency_max;
+
+/* set to 1 if the mouse has been moved out of the dead zone to rotate the
+ship about the y or x axis */
+int mouse_roty_flag = 0, mouse_rotx_flag = 0;
+
+/* the proportion the mouse has moved out of the dead zone */
+double mouse_xprop = 0, mouse_yprop = 0;
+
+/* Window size and dead zone boundaries, as of the last INPUT_RESIZE */
+static int window_w, window_h;
+static int mouse_left_bound, mouse_right_bound, mouse_top_bound,
+	mouse_bottom_bound;
+
+//-----------------------------------------------------------------------------
+/* Queue an event for the sim thread. Called by the GLUT callbacks only. */
+void post_input_event(int type, int code, int x, int y)
+{
+	unsigned int head = ring_head;
+	struct timespec now;
+	InputEvent *e;
+
+	if (head - __atomic_load_n(&ring_tail, __ATOMIC_ACQUIRE) ==
+	    INPUT_RING_SIZE) {
+		++dropped_events;
+		return;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	e        = &ring[head % INPUT_RING_SIZE];
+	e->type  = type;
+	e->code  = code;
+	e->x     = x;
+	e->y     = y;
+	e->stamp = now.tv_sec + now.tv_nsec / 1e9;
+	__atomic_store_n(&ring_head, head + 1, __ATOMIC_RELEASE);
+	return;
+}
+
+/* Apply every queued event, oldest first. Called by the sim thread at the
+start of a tick. */
+void process_input(void)
+{
+	unsigned int tail = ring_tail;
+	unsigned int head = __atomic_load_n(&ring_head, __ATOMIC_ACQUIRE);
+	struct timespec now;
+	const InputEvent *e;
+	double latency;
+
+	if (tail == head)
+		return;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	for (; tail != head; ++tail) {
+		e       = &ring[tail % INPUT_RING_SIZE];
+		latency = now.tv_sec + now.tv_nsec / 1e9 - e->stamp;
+		latency_time += latency;
+		if (latency > latency_max)
+			latency_max = latency;
+		apply_event(e);
+	}
+
+	drained_events += head - ring_tail;
+	__atomic_store_n(&ring_tail, tail, __ATOMIC_RELEASE);
+	return;
+}
+
+static void apply_event(const InputEvent *e)
+{
+	switch (e->type) {
+		case INPUT_KEY:
+			apply_key(e->code);
+			break;
+		case INPUT_BUTTON:
+			if (e->code == GLUT_LEFT_BUTTON)
+				fire_torpedo();
+			else if (e->code == GLUT_RIGHT_BUTTON)
+				target_asteroid();
+			break;
+		case INPUT_MOTION:
+			steer_by_pointer(e->x, e->y);
+			break;
+		case INPUT_RESIZE:
+			set_dead_zone(e->x, e->y);
+			break;
+	}
+	return;
+}
+
+static void set_dead_zone(int w, int h)
+{
+	window_w = w;
+	window_h = h;
+	mouse_left_bound   = w / 2 - 50;
+	mouse_right_bound  = w / 2 + 50;
+	mouse_top_bound    = h / 2 - 50;
+	mouse_bottom_bound = h / 2 + 50;
+	return;
+}
+
+/* x, y are the pointer position in window coordinates */
+static void steer_by_pointer(int x, int y)
+{
+	/* if mouse is inside dead zone */
+	if (x > mouse_left_bound && x < mouse_right_bound &&
+	    y > mouse_top_bound && y < mouse_bottom_bound) {
+		mouse_roty_flag = 0;
+		mouse_rotx_flag = 0;
+		return;
+	}
+
+	/* if mouse is not in the dead zone set the flag */
+	if (x > mouse_right_bound) {
+		mouse_roty_flag = 1;
+		mouse_yprop = static_cast(double, x - mouse_right_bound) /
+		              (window_w - mouse_right_bound);
+	}
+
+	if (x < mouse_left_bound) {
+		mouse_roty_flag = 1;
+		mouse_yprop = -1 + static_cast(double, x) / mouse_left_bound;
+	}
+
+	if (y < mouse_top_bound) {
+		mouse_rotx_flag = 1;
+		mouse_xprop = 1 - static_cast(double, y) / mouse_top_bound;
+	}
+
+	if (y > mouse_bottom_bound) {
+		mouse_rotx_flag = 1;
+		mouse_xprop = static_cast(double, -(y - mouse_bottom_bound)) /
+		              (window_h - mouse_bottom_bound);
+	}
+
+	/* for reversing mouse direction */
+	mouse_yprop = mouse_yprop * optmap.mouse_ydir;
+	mouse_xprop = mouse_xprop * optmap.mouse_xdir;
+	return;
+}
+
+void print_input_stats(void)
+{
+	printf("Input events: %lu applied, %.0f us from callback to tick on "
+	       "average, longest %.0f us, %lu dropped\n", drained_events,
+	       (drained_events > 0) ? latency_time * 1e6 / drained_events : 0,
+	       latency_max * 1e6, dropped_events);
+	return;
+}
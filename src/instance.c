@@ -0,0 +1,454 @@
+/* Asteroids3D - a first person game of blowing up asteroids
+ * Copyright (C) 2000 Stuart Mark Pomerantz <smp [at] psc edu>
+ * Copyright © Jan Engelhardt <jengelh [at] gmx de>, 2003 - 2006
+ *
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  Stuart Pomerantz
+ *  3935 Stonecliffe drive
+ *  Monroeville, PA 15146
+ */
+
+/*
+ * Instanced drawing of the asteroids. Drawing a rock through its display
+list takes a push, a translate, a rotate, a texture bind, the call and a pop,
+which at a few thousand rocks keeps the driver busier than the GPU. Here the
+asteroid shapes live in a vertex and an index buffer, the position and spin
+of every rock visible in a frame go into one instance buffer, and all rocks
+of a kind are drawn by a single glDrawElementsInstanced().
+ *
+ * The vertex shader places each rock and does the lighting the fixed
+function pipeline would, from the same GL light and material state; the
+fragment side, texturing with GL_MODULATE and flat shading included, stays
+fixed function. This takes GL 2.0 and instanced arrays (GL 3.3 or
+ARB_instanced_arrays). Without them, or with the instanced_asteroids option
+off, display() goes on to use the display lists.
+ */
+
+#include <GL/glut.h>
+#include <GL/glext.h>
+#include <GL/glx.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "asteroids3D.h"
+
+/* Generic vertex attributes of the instance data. 0 is left alone, as some
+drivers alias it to gl_Vertex. */
+#define ATTR_INST_POS 1
+#define ATTR_INST_ROT 2
+
+/* Number of lights the shader looks at, GL_LIGHT0 .. GL_LIGHT2. The
+shader source has it too. */
+#define NUM_ROCK_LIGHTS 3
+
+/* What the instance buffer holds for each rock */
+struct rock_instance {
+	float pos[3];
+	float rot[4]; // axis, then the angle in degrees
+};
+
+static int compile_shader(GLenum, const char *);
+static int load_gl_procs(int);
+static int setup_program(void);
+static void setup_buffers(void);
+
+static const char rock_vertex_shader[] =
+	"#version 120\n"
+	"attribute vec3 inst_pos;\n"
+	"attribute vec4 inst_rot;\n"
+	"uniform float scale;\n"
+	"uniform float light_on[3];\n"
+	"\n"
+	"vec3 rotate(vec3 v, vec3 a, float c, float s)\n"
+	"{\n"
+	"	return v * c + cross(a, v) * s + a * dot(a, v) * (1.0 - c);\n"
+	"}\n"
+	"\n"
+	"void main(void)\n"
+	"{\n"
+	"	vec3 axis = normalize(inst_rot.xyz);\n"
+	"	float angle = radians(inst_rot.w);\n"
+	"	float c = cos(angle), s = sin(angle);\n"
+	"	vec4 p = vec4(rotate(gl_Vertex.xyz * scale, axis, c, s) +\n"
+	"	         inst_pos, 1.0);\n"
+	"	vec4 eye = gl_ModelViewMatrix * p;\n"
+	"	/* the inverse transpose of the scaling, no GL_NORMALIZE */\n"
+	"	vec3 n = gl_NormalMatrix * rotate(gl_Normal, axis, c, s) / scale;\n"
+	"	vec3 view = -normalize(eye.xyz);\n"
+	"	vec4 color = gl_FrontLightModelProduct.sceneColor;\n"
+	"	int i;\n"
+	"\n"
+	"	for (i = 0; i < 3; ++i) {\n"
+	"		vec4 lp = gl_LightSource[i].position;\n"
+	"		vec3 l = lp.xyz - eye.xyz * lp.w;\n"
+	"		float d = length(l);\n"
+	"		float f = 1.0;\n"
+	"		float nl, nh, spot;\n"
+	"\n"
+	"		if (light_on[i] == 0.0)\n"
+	"			continue;\n"
+	"		l /= d;\n"
+	"		if (lp.w != 0.0)\n"
+	"			f /= gl_LightSource[i].constantAttenuation +\n"
+	"			     gl_LightSource[i].linearAttenuation * d +\n"
+	"			     gl_LightSource[i].quadraticAttenuation * d * d;\n"
+	"		if (gl_LightSource[i].spotCutoff != 180.0) {\n"
+	"			spot = dot(-l, normalize(gl_LightSource[i].spotDirection));\n"
+	"			f *= (spot < gl_LightSource[i].spotCosCutoff) ? 0.0 :\n"
+	"			     pow(spot, gl_LightSource[i].spotExponent);\n"
+	"		}\n"
+	"		nl = dot(n, l);\n"
+	"		color += f * gl_FrontLightProduct[i].ambient;\n"
+	"		if (nl <= 0.0)\n"
+	"			continue;\n"
+	"		/* pow(0, 0) is undefined, the shininess 0 by default */\n"
+	"		nh = max(dot(n, normalize(l + view)), 0.0);\n"
+	"		nh = (gl_FrontMaterial.shininess == 0.0) ? 1.0 :\n"
+	"		     pow(nh, gl_FrontMaterial.shininess);\n"
+	"		color += f * (nl * gl_FrontLightProduct[i].diffuse +\n"
+	"		         nh * gl_FrontLightProduct[i].specular);\n"
+	"	}\n"
+	"\n"
+	"	gl_FrontColor = vec4(clamp(color.rgb, 0.0, 1.0),\n"
+	"	                gl_FrontMaterial.diffuse.a);\n"
+	"	gl_TexCoord[0] = gl_TextureMatrix[0] * gl_MultiTexCoord0;\n"
+	"	gl_Position = gl_ModelViewProjectionMatrix * p;\n"
+	"}\n";
+
+/* The GL 1.5 - 3.3 functions used here, looked up by load_gl_procs() */
+static PFNGLATTACHSHADERPROC            p_glAttachShader;
+static PFNGLBINDATTRIBLOCATIONPROC      p_glBindAttribLocation;
+static PFNGLBINDBUFFERPROC              p_glBindBuffer;
+static PFNGLBUFFERDATAPROC              p_glBufferData;
+static PFNGLBUFFERSUBDATAPROC           p_glBufferSubData;
+static PFNGLCOMPILESHADERPROC           p_glCompileShader;
+static PFNGLCREATEPROGRAMPROC           p_glCreateProgram;
+static PFNGLCREATESHADERPROC            p_glCreateShader;
+static PFNGLDISABLEVERTEXATTRIBARRAYPROC p_glDisableVertexAttribArray;
+static PFNGLDRAWELEMENTSINSTANCEDPROC   p_glDrawElementsInstanced;
+static PFNGLENABLEVERTEXATTRIBARRAYPROC p_glEnableVertexAttribArray;
+static PFNGLGENBUFFERSPROC              p_glGenBuffers;
+static PFNGLGETPROGRAMINFOLOGPROC       p_glGetProgramInfoLog;
+static PFNGLGETPROGRAMIVPROC            p_glGetProgramiv;
+static PFNGLGETSHADERINFOLOGPROC        p_glGetShaderInfoLog;
+static PFNGLGETSHADERIVPROC             p_glGetShaderiv;
+static PFNGLGETUNIFORMLOCATIONPROC      p_glGetUniformLocation;
+static PFNGLLINKPROGRAMPROC             p_glLinkProgram;
+static PFNGLSHADERSOURCEPROC            p_glShaderSource;
+static PFNGLUNIFORM1FPROC               p_glUniform1f;
+static PFNGLUNIFORM1FVPROC              p_glUniform1fv;
+static PFNGLUSEPROGRAMPROC              p_glUseProgram;
+static PFNGLVERTEXATTRIBDIVISORPROC     p_glVertexAttribDivisor;
+static PFNGLVERTEXATTRIBPOINTERPROC     p_glVertexAttribPointer;
+
+/* arb: the name has an ARB suffix when GL is older than 3.3 */
+#define GL_PROC(name, arb) \
+	{#name, reinterpret_cast(void (**)(void), &p_ ## name), arb}
+static const struct gl_proc {
+	const char *name;
+	void (**proc)(void);
+	int arb;
+} gl_procs[] = {
+	GL_PROC(glAttachShader, 0),
+	GL_PROC(glBindAttribLocation, 0),
+	GL_PROC(glBindBuffer, 0),
+	GL_PROC(glBufferData, 0),
+	GL_PROC(glBufferSubData, 0),
+	GL_PROC(glCompileShader, 0),
+	GL_PROC(glCreateProgram, 0),
+	GL_PROC(glCreateShader, 0),
+	GL_PROC(glDisableVertexAttribArray, 0),
+	GL_PROC(glDrawElementsInstanced, 1),
+	GL_PROC(glEnableVertexAttribArray, 0),
+	GL_PROC(glGenBuffers, 0),
+	GL_PROC(glGetProgramInfoLog, 0),
+	GL_PROC(glGetProgramiv, 0),
+	GL_PROC(glGetShaderInfoLog, 0),
+	GL_PROC(glGetShaderiv, 0),
+	GL_PROC(glGetUniformLocation, 0),
+	GL_PROC(glLinkProgram, 0),
+	GL_PROC(glShaderSource, 0),
+	GL_PROC(glUniform1f, 0),
+	GL_PROC(glUniform1fv, 0),
+	GL_PROC(glUseProgram, 0),
+	GL_PROC(glVertexAttribDivisor, 1),
+	GL_PROC(glVertexAttribPointer, 0),
+};
+#undef GL_PROC
+
+static int instancing_ready = 0;
+static GLuint rock_program, mesh_buffer, index_buffer, instance_buffer;
+static GLint scale_loc, light_on_loc;
+
+/* Where each asteroid shape starts in index_buffer */
+static size_t mesh_first_index[NUM_AST_TYPES];
+
+/* The instances of a frame, sorted by type, and how many there are of
+each type. Only used by the thread that draws. */
+static struct rock_instance *instance;
+static unsigned int instance_capacity;
+static unsigned int type_count[NUM_AST_TYPES];
+
+//-----------------------------------------------------------------------------
+/* Set up the buffers and the shader, if GL can do it. Must be called with
+the GL context current, after init_models(). */
+void init_instancing(void)
+{
+	const char *version = reinterpret_cast(const char *,
+	                      glGetString(GL_VERSION));
+	const char *ext = reinterpret_cast(const char *,
+	                  glGetString(GL_EXTENSIONS));
+	int major = 0, minor = 0, arb;
+
+	if (version != NULL)
+		sscanf(version, "%d.%d", &major, &minor);
+	arb = major < 3 || (major == 3 && minor < 3);
+
+	if (major < 2 || (arb && (ext == NULL ||
+	    strstr(ext, "GL_ARB_instanced_arrays") == NULL)))
+	{
+		printf("Asteroids: display lists (GL %s has no instanced "
+		       "arrays)\n", (version != NULL) ? version : "?");
+		return;
+	}
+	if (!load_gl_procs(arb) || !setup_program()) {
+		printf("Asteroids: display lists\n");
+		return;
+	}
+
+	setup_buffers();
+	instancing_ready = 1;
+	printf("Asteroids: instanced drawing\n");
+	return;
+}
+
+/* Look the functions up, with the ARB names where needed */
+static int load_gl_procs(int arb)
+{
+	char name[64];
+	unsigned int i;
+
+	for (i = 0; i < sizeof(gl_procs) / sizeof(*gl_procs); ++i) {
+		snprintf(name, sizeof(name), "%s%s", gl_procs[i].name,
+		         (arb && gl_procs[i].arb) ? "ARB" : "");
+		*gl_procs[i].proc = glXGetProcAddressARB(
+		                    reinterpret_cast(const GLubyte *, name));
+		if (*gl_procs[i].proc == NULL) {
+			fprintf(stderr, "No %s in this GL\n", name);
+			return 0;
+		}
+	}
+	return 1;
+}
+
+static int setup_program(void)
+{
+	char log[1024];
+	GLint ok;
+	int vs;
+
+	if ((vs = compile_shader(GL_VERTEX_SHADER, rock_vertex_shader)) == 0)
+		return 0;
+
+	rock_program = p_glCreateProgram();
+	p_glAttachShader(rock_program, vs);
+	p_glBindAttribLocation(rock_program, ATTR_INST_POS, "inst_pos");
+	p_glBindAttribLocation(rock_program, ATTR_INST_ROT, "inst_rot");
+	p_glLinkProgram(rock_program);
+	p_glGetProgramiv(rock_program, GL_LINK_STATUS, &ok);
+	if (!ok) {
+		p_glGetProgramInfoLog(rock_program, sizeof(log), NULL, log);
+		fprintf(stderr, "Could not link the asteroid shader:\n%s\n",
+		        log);
+		return 0;
+	}
+
+	scale_loc    = p_glGetUniformLocation(rock_program, "scale");
+	light_on_loc = p_glGetUniformLocation(rock_program, "light_on");
+	return 1;
+}
+
+/* Returns the shader object, or 0 */
+static int compile_shader(GLenum type, const char *source)
+{
+	GLuint shader = p_glCreateShader(type);
+	char log[1024];
+	GLint ok;
+
+	p_glShaderSource(shader, 1, &source, NULL);
+	p_glCompileShader(shader);
+	p_glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+	if (!ok) {
+		p_glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+		fprintf(stderr, "Could not compile the asteroid shader:\n%s\n",
+		        log);
+		return 0;
+	}
+	return shader;
+}
+
+/* Put all asteroid shapes into one vertex and one index buffer */
+static void setup_buffers(void)
+{
+	unsigned int vertices = 0, indices = 0, i, k;
+	size_t vo = 0, io = 0;
+	unsigned short *index;
+
+	for (i = 0; i < NUM_AST_TYPES; ++i) {
+		vertices += ast_mesh[i].num_vertices;
+		indices  += ast_mesh[i].num_indices;
+	}
+
+	p_glGenBuffers(1, &mesh_buffer);
+	p_glBindBuffer(GL_ARRAY_BUFFER, mesh_buffer);
+	p_glBufferData(GL_ARRAY_BUFFER, vertices * sizeof(RockVertex), NULL,
+	    GL_STATIC_DRAW);
+	p_glGenBuffers(1, &index_buffer);
+	p_glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer);
+	p_glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices * sizeof(*index), NULL,
+	    GL_STATIC_DRAW);
+
+	/* the indices of each shape count from where its vertices went */
+	for (i = 0; i < NUM_AST_TYPES; ++i) {
+		const RockMesh *m = &ast_mesh[i];
+
+		if ((index = malloc(m->num_indices * sizeof(*index))) == NULL) {
+			perror("malloc");
+			exit(EXIT_FAILURE);
+		}
+		for (k = 0; k < m->num_indices; ++k)
+			index[k] = vo + m->index[k];
+
+		p_glBufferSubData(GL_ARRAY_BUFFER, vo * sizeof(RockVertex),
+		    m->num_vertices * sizeof(RockVertex), m->vertex);
+		p_glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, io * sizeof(*index),
+		    m->num_indices * sizeof(*index), index);
+		free(index);
+		mesh_first_index[i] = io;
+		vo += m->num_vertices;
+		io += m->num_indices;
+	}
+
+	p_glGenBuffers(1, &instance_buffer);
+	p_glBindBuffer(GL_ARRAY_BUFFER, 0);
+	p_glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	return;
+}
+
+/* Draw the n rocks with one call per asteroid type. Returns 0 without
+drawing anything when instancing cannot be used. */
+int draw_instanced_asteroids(const SnapRock *rock, unsigned int n)
+{
+	unsigned int first[NUM_AST_TYPES], i, t;
+	struct rock_instance *p;
+	float light_on[NUM_ROCK_LIGHTS];
+
+	if (!instancing_ready || !optmap.instancing_flag)
+		return 0;
+	if (n == 0)
+		return 1;
+
+	if (n > instance_capacity) {
+		free(instance);
+		if ((instance = malloc(n * sizeof(*instance))) == NULL) {
+			perror("malloc");
+			exit(EXIT_FAILURE);
+		}
+		instance_capacity = n;
+	}
+
+	/* counting sort by type */
+	memset(type_count, 0, sizeof(type_count));
+	for (i = 0; i < n; ++i)
+		++type_count[rock[i].type];
+	for (t = 0, i = 0; t < NUM_AST_TYPES; ++t) {
+		first[t] = i;
+		i += type_count[t];
+	}
+	for (i = 0; i < n; ++i) {
+		p = &instance[first[rock[i].type]++];
+		memcpy(p->pos, rock[i].pos, sizeof(p->pos));
+		memcpy(p->rot, rock[i].rot_axis, sizeof(rock[i].rot_axis));
+		p->rot[3] = rock[i].rot;
+	}
+
+	/* a fresh store each frame, so the driver need not wait for the
+	last frame's draws to be done with the old one */
+	p_glBindBuffer(GL_ARRAY_BUFFER, instance_buffer);
+	p_glBufferData(GL_ARRAY_BUFFER, n * sizeof(*instance), instance,
+	    GL_STREAM_DRAW);
+
+	for (i = 0; i < NUM_ROCK_LIGHTS; ++i)
+		light_on[i] = glIsEnabled(GL_LIGHT0 + i);
+	p_glUseProgram(rock_program);
+	p_glUniform1fv(light_on_loc, NUM_ROCK_LIGHTS, light_on);
+	gl_ast_material();
+	if (optmap.texture_flag)
+		glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+
+	p_glBindBuffer(GL_ARRAY_BUFFER, mesh_buffer);
+	p_glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer);
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_NORMAL_ARRAY);
+	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+	glVertexPointer(3, GL_FLOAT, sizeof(RockVertex),
+	    reinterpret_cast(void *, offsetof(RockVertex, pos)));
+	glNormalPointer(GL_FLOAT, sizeof(RockVertex),
+	    reinterpret_cast(void *, offsetof(RockVertex, normal)));
+	glTexCoordPointer(2, GL_FLOAT, sizeof(RockVertex),
+	    reinterpret_cast(void *, offsetof(RockVertex, tc)));
+
+	p_glBindBuffer(GL_ARRAY_BUFFER, instance_buffer);
+	p_glEnableVertexAttribArray(ATTR_INST_POS);
+	p_glEnableVertexAttribArray(ATTR_INST_ROT);
+	p_glVertexAttribDivisor(ATTR_INST_POS, 1);
+	p_glVertexAttribDivisor(ATTR_INST_ROT, 1);
+
+	for (t = 0, i = 0; t < NUM_AST_TYPES; i += type_count[t++]) {
+		if (type_count[t] == 0)
+			continue;
+		/* no base instance before GL 4.2, so point at the type's
+		first instance instead */
+		p_glVertexAttribPointer(ATTR_INST_POS, 3, GL_FLOAT, GL_FALSE,
+		    sizeof(*instance), reinterpret_cast(void *, i *
+		    sizeof(*instance) + offsetof(struct rock_instance, pos)));
+		p_glVertexAttribPointer(ATTR_INST_ROT, 4, GL_FLOAT, GL_FALSE,
+		    sizeof(*instance), reinterpret_cast(void *, i *
+		    sizeof(*instance) + offsetof(struct rock_instance, rot)));
+		p_glUniform1f(scale_loc, ast_mesh[t].scale);
+		if (optmap.texture_flag)
+			glBindTexture(GL_TEXTURE_2D, ast_tex[t]);
+		p_glDrawElementsInstanced(GL_TRIANGLES, ast_mesh[t].num_indices,
+		    GL_UNSIGNED_SHORT, reinterpret_cast(void *,
+		    mesh_first_index[t] * sizeof(unsigned short)), type_count[t]);
+	}
+
+	p_glVertexAttribDivisor(ATTR_INST_POS, 0);
+	p_glVertexAttribDivisor(ATTR_INST_ROT, 0);
+	p_glDisableVertexAttribArray(ATTR_INST_POS);
+	p_glDisableVertexAttribArray(ATTR_INST_ROT);
+	glDisableClientState(GL_VERTEX_ARRAY);
+	glDisableClientState(GL_NORMAL_ARRAY);
+	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+	p_glBindBuffer(GL_ARRAY_BUFFER, 0);
+	p_glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	p_glUseProgram(0);
+	if (optmap.texture_flag)
+		glBindTexture(GL_TEXTURE_2D, 0);
+	return 1;
+}
@@ -0,0 +1,375 @@
+/* Asteroids3D - a first person game of blowing up asteroids
+ * Copyright (C) 2000 Stuart Mark Pomerantz <smp [at] psc edu>
+ * Copyright © Jan Engelhardt <jengelh [at] gmx de>, 2003 - 2006
+ *
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  Stuart Pomerantz
+ *  3935 Stonecliffe drive
+ *  Monroeville, PA 15146
+ */
+
+/*
+ * Integrate-and-wrap kernels for the asteroid positions. Each moves n rocks
+one step along their velocity and wraps them around the ABOUND torus centred
+on the player, exactly like the scalar reference. The rocks are stored as
+x, y, z, w vectors, so the vector kernels load a group of them and
+transpose it in registers: the AVX2 kernel works on 4 rocks per instruction
+(4 doubles), the SSE2 one on 2. Each coordinate is then moved and wrapped
+for the whole group by one multiply, one add, two compares and two blends,
+and the unused w lane costs no arithmetic. The remainder of a group is left
+to the scalar code. Only plain multiplies and adds are used, never fused
+ones, so all kernels round alike and give bit-identical positions.
+ *
+ * The AST_FLOAT32 layout has its own scalar and SSE2 kernels. There a rock
+is four floats, and the SSE2 kernel transposes groups of 4 rocks likewise.
+They work in single precision throughout, with the bounds rounded to
+floats.
+ */
+
+#include <math.h>
+#include <string.h>
+#include "asteroids3D.h"
+#include "vecops.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#	define HAVE_X86_KERNELS 1
+#	include <immintrin.h>
+#endif
+
+/* The six values one coordinate of a rock is compared with or set to */
+struct wrap_bounds {
+	double above;   // center + ABOUND: wrap when past this
+	double below;   // center - ABOUND: wrap when short of this
+	double to_low;  // where a rock past the upper bound reappears
+	double to_high; // where a rock short of the lower bound reappears
+};
+
+static void get_bounds(struct wrap_bounds *, const Vector *);
+#if defined(HAVE_X86_KERNELS) && !defined(AST_FLOAT32)
+static void integrate_wrap_avx2(AstVec *, const AstVec *, unsigned int,
+    double, const Vector *);
+#endif
+#ifdef HAVE_X86_KERNELS
+static void integrate_wrap_sse2(AstVec *, const AstVec *, unsigned int,
+    double, const Vector *);
+#endif
+
+static const struct {
+	const char *name;
+	IntegrateFunc func;
+} integrate_kernels[] = {
+#if defined(HAVE_X86_KERNELS) && !defined(AST_FLOAT32)
+	{"avx2",   integrate_wrap_avx2},
+#endif
+#ifdef HAVE_X86_KERNELS
+	{"sse2",   integrate_wrap_sse2},
+#endif
+	{"scalar", integrate_wrap_scalar},
+};
+#define NUM_KERNELS (sizeof(integrate_kernels) / sizeof(*integrate_kernels))
+
+/* Selected by init_integrate() */
+static IntegrateFunc integrate_impl = integrate_wrap_scalar;
+
+//-----------------------------------------------------------------------------
+/* Pick the fastest kernel this CPU supports and return its name */
+const char *init_integrate(void)
+{
+	unsigned int i;
+
+	for (i = 0; i < NUM_KERNELS; ++i)
+		if (integrate_kernel(integrate_kernels[i].name) != NULL)
+			break;
+	integrate_impl = integrate_kernels[i].func;
+	return integrate_kernels[i].name;
+}
+
+/* The named kernel, or NULL if it is unknown or the CPU lacks it */
+IntegrateFunc integrate_kernel(const char *name)
+{
+	unsigned int i;
+
+	for (i = 0; i < NUM_KERNELS; ++i)
+		if (strcmp(name, integrate_kernels[i].name) == 0)
+			break;
+	if (i == NUM_KERNELS)
+		return NULL;
+
+#ifdef HAVE_X86_KERNELS
+	__builtin_cpu_init();
+#ifndef AST_FLOAT32
+	if (integrate_kernels[i].func == integrate_wrap_avx2 &&
+	    !__builtin_cpu_supports("avx2"))
+		return NULL;
+#endif
+	if (integrate_kernels[i].func == integrate_wrap_sse2 &&
+	    !__builtin_cpu_supports("sse2"))
+		return NULL;
+#endif
+	return integrate_kernels[i].func;
+}
+
+void integrate_wrap(AstVec *p, const AstVec *v, unsigned int n,
+    double step, const Vector *center)
+{
+	integrate_impl(p, v, n, step, center);
+	return;
+}
+
+static void get_bounds(struct wrap_bounds *b, const Vector *center)
+{
+	const double c[3] = {center->x, center->y, center->z};
+	unsigned int k;
+
+	for (k = 0; k < 3; ++k) {
+		b[k].above   = c[k] + ABOUND;
+		b[k].below   = c[k] - ABOUND;
+		b[k].to_low  = c[k] - ABOUND + 10;
+		b[k].to_high = c[k] + ABOUND - 10;
+	}
+	return;
+}
+
+#ifdef AST_FLOAT32
+void integrate_wrap_scalar(AstVec *p, const AstVec *v, unsigned int n,
+    double step, const Vector *center)
+{
+	struct wrap_bounds b[3];
+	float above[3], below[3], to_low[3], to_high[3], f = step, *x;
+	const float *w;
+	unsigned int i, k;
+
+	get_bounds(b, center);
+	for (k = 0; k < 3; ++k) {
+		above[k]   = b[k].above;
+		below[k]   = b[k].below;
+		to_low[k]  = b[k].to_low;
+		to_high[k] = b[k].to_high;
+	}
+
+	for (i = 0; i < n; ++i)
+		for (k = 0, x = &p[i].x, w = &v[i].x; k < 3; ++k, ++x, ++w) {
+			*x = *x + f * *w;
+			if (*x > above[k])
+				*x = to_low[k];
+			if (*x < below[k])
+				*x = to_high[k];
+		}
+	return;
+}
+
+#ifdef HAVE_X86_KERNELS
+/* One coordinate of 4 rocks: x + f * v, wrapped by the bounds */
+__attribute__((target("sse2")))
+static inline __m128 wrap4_ps(__m128 x, __m128 v, __m128 f, float above,
+    float below, float to_low, float to_high)
+{
+	__m128 m;
+
+	x = _mm_add_ps(x, _mm_mul_ps(f, v));
+	m = _mm_cmpgt_ps(x, _mm_set1_ps(above));
+	x = _mm_or_ps(_mm_and_ps(m, _mm_set1_ps(to_low)), _mm_andnot_ps(m, x));
+	m = _mm_cmplt_ps(x, _mm_set1_ps(below));
+	return _mm_or_ps(_mm_and_ps(m, _mm_set1_ps(to_high)),
+	       _mm_andnot_ps(m, x));
+}
+
+__attribute__((target("sse2")))
+static void integrate_wrap_sse2(AstVec *p, const AstVec *v, unsigned int n,
+    double step, const Vector *center)
+{
+	struct wrap_bounds b[3];
+	__m128 f = _mm_set1_ps(step), x[4], w[4];
+	unsigned int i, k, groups = n / 4;
+
+	/* Four rocks are transposed so that each register holds one
+	coordinate of all four, and the w members are stored back as they
+	were. */
+	get_bounds(b, center);
+	for (i = 0; i < groups; ++i, p += 4, v += 4) {
+		for (k = 0; k < 4; ++k) {
+			x[k] = _mm_loadu_ps(&p[k].x);
+			w[k] = _mm_loadu_ps(&v[k].x);
+		}
+		_MM_TRANSPOSE4_PS(x[0], x[1], x[2], x[3]);
+		_MM_TRANSPOSE4_PS(w[0], w[1], w[2], w[3]);
+		for (k = 0; k < 3; ++k)
+			x[k] = wrap4_ps(x[k], w[k], f, b[k].above, b[k].below,
+			       b[k].to_low, b[k].to_high);
+		_MM_TRANSPOSE4_PS(x[0], x[1], x[2], x[3]);
+		for (k = 0; k < 4; ++k)
+			_mm_storeu_ps(&p[k].x, x[k]);
+	}
+
+	integrate_wrap_scalar(p, v, n % 4, step, center);
+	return;
+}
+#endif // HAVE_X86_KERNELS
+
+#else // !AST_FLOAT32
+
+void integrate_wrap_scalar(AstVec *p, const AstVec *v, unsigned int n,
+    double step, const Vector *center)
+{
+	struct wrap_bounds b[3];
+	double *x;
+	unsigned int i, k;
+
+	get_bounds(b, center);
+	for (i = 0; i < n; ++i) {
+		vec_addmul(&p[i], &p[i], step, &v[i]);
+		for (k = 0, x = &p[i].x; k < 3; ++k, ++x) {
+			if (*x > b[k].above)
+				*x = b[k].to_low;
+			if (*x < b[k].below)
+				*x = b[k].to_high;
+		}
+	}
+	return;
+}
+
+#ifdef HAVE_X86_KERNELS
+/* The bounds of one coordinate, in every lane */
+struct wrap_bounds4 {
+	__m256d above, below, to_low, to_high;
+};
+
+/* One coordinate of 4 rocks: x + f * v, wrapped by the bounds b */
+#define WRAP4_PD(x, v, f, b) do { \
+	(x) = _mm256_add_pd((x), _mm256_mul_pd((f), (v))); \
+	(x) = _mm256_blendv_pd((x), (b).to_low, \
+	      _mm256_cmp_pd((x), (b).above, _CMP_GT_OQ)); \
+	(x) = _mm256_blendv_pd((x), (b).to_high, \
+	      _mm256_cmp_pd((x), (b).below, _CMP_LT_OQ)); \
+} while (0)
+
+/* Rows r0..r3 of a 4x4 matrix of doubles become its columns */
+#define TRANSPOSE4_PD(r0, r1, r2, r3) do { \
+	__m256d t0_ = _mm256_unpacklo_pd((r0), (r1)); /* x0 x1 z0 z1 */ \
+	__m256d t1_ = _mm256_unpackhi_pd((r0), (r1)); /* y0 y1 w0 w1 */ \
+	__m256d t2_ = _mm256_unpacklo_pd((r2), (r3)); /* x2 x3 z2 z3 */ \
+	__m256d t3_ = _mm256_unpackhi_pd((r2), (r3)); /* y2 y3 w2 w3 */ \
+	(r0) = _mm256_permute2f128_pd(t0_, t2_, 0x20); \
+	(r1) = _mm256_permute2f128_pd(t1_, t3_, 0x20); \
+	(r2) = _mm256_permute2f128_pd(t0_, t2_, 0x31); \
+	(r3) = _mm256_permute2f128_pd(t1_, t3_, 0x31); \
+} while (0)
+
+__attribute__((target("avx2")))
+static void integrate_wrap_avx2(AstVec *p, const AstVec *v, unsigned int n,
+    double step, const Vector *center)
+{
+	const double c[3] = {center->x, center->y, center->z};
+	struct wrap_bounds4 b4[3];
+	__m256d f = _mm256_set1_pd(step), x0, x1, x2, x3, v0, v1, v2, v3;
+	unsigned int i, k, groups = n / 4;
+
+	/*
+	 * The bounds are those of get_bounds(), worked out here because that
+	is SSE code: calling it with live AVX registers costs a state
+	transition on every call, which swamps the work for a few rocks.
+	 */
+	for (k = 0; k < 3; ++k) {
+		b4[k].above   = _mm256_set1_pd(c[k] + ABOUND);
+		b4[k].below   = _mm256_set1_pd(c[k] - ABOUND);
+		b4[k].to_low  = _mm256_set1_pd(c[k] - ABOUND + 10);
+		b4[k].to_high = _mm256_set1_pd(c[k] + ABOUND - 10);
+	}
+
+	/* Four rocks are transposed so that each register holds one
+	coordinate of all four; x3 ends up with their w members, which go
+	back as they were. */
+	for (i = 0; i < groups; ++i, p += 4, v += 4) {
+		x0 = _mm256_loadu_pd(&p[0].x);
+		x1 = _mm256_loadu_pd(&p[1].x);
+		x2 = _mm256_loadu_pd(&p[2].x);
+		x3 = _mm256_loadu_pd(&p[3].x);
+		v0 = _mm256_loadu_pd(&v[0].x);
+		v1 = _mm256_loadu_pd(&v[1].x);
+		v2 = _mm256_loadu_pd(&v[2].x);
+		v3 = _mm256_loadu_pd(&v[3].x);
+		TRANSPOSE4_PD(x0, x1, x2, x3);
+		TRANSPOSE4_PD(v0, v1, v2, v3);
+		WRAP4_PD(x0, v0, f, b4[0]);
+		WRAP4_PD(x1, v1, f, b4[1]);
+		WRAP4_PD(x2, v2, f, b4[2]);
+		TRANSPOSE4_PD(x0, x1, x2, x3);
+		_mm256_storeu_pd(&p[0].x, x0);
+		_mm256_storeu_pd(&p[1].x, x1);
+		_mm256_storeu_pd(&p[2].x, x2);
+		_mm256_storeu_pd(&p[3].x, x3);
+	}
+
+	/* leave no dirty upper halves behind for the SSE code that follows */
+	_mm256_zeroupper();
+	integrate_wrap_scalar(p, v, n % 4, step, center);
+	return;
+}
+
+/* One coordinate of 2 rocks, as wrap4_pd() */
+__attribute__((target("sse2")))
+static inline __m128d wrap2_pd(__m128d x, __m128d v, __m128d f,
+    const struct wrap_bounds *b)
+{
+	__m128d m;
+
+	x = _mm_add_pd(x, _mm_mul_pd(f, v));
+	m = _mm_cmpgt_pd(x, _mm_set1_pd(b->above));
+	x = _mm_or_pd(_mm_and_pd(m, _mm_set1_pd(b->to_low)),
+	    _mm_andnot_pd(m, x));
+	m = _mm_cmplt_pd(x, _mm_set1_pd(b->below));
+	return _mm_or_pd(_mm_and_pd(m, _mm_set1_pd(b->to_high)),
+	       _mm_andnot_pd(m, x));
+}
+
+__attribute__((target("sse2")))
+static void integrate_wrap_sse2(AstVec *p, const AstVec *v, unsigned int n,
+    double step, const Vector *center)
+{
+	struct wrap_bounds b[3];
+	__m128d f = _mm_set1_pd(step), xy0, xy1, zw0, zw1, x[3], w[3];
+	unsigned int i, groups = n / 2;
+
+	/* Two rocks at a time, one register per coordinate: (x0, x1),
+	(y0, y1) and (z0, z1). The w members are stored back as they were. */
+	get_bounds(b, center);
+	for (i = 0; i < groups; ++i, p += 2, v += 2) {
+		xy0  = _mm_loadu_pd(&p[0].x);
+		xy1  = _mm_loadu_pd(&p[1].x);
+		zw0  = _mm_loadu_pd(&p[0].z);
+		zw1  = _mm_loadu_pd(&p[1].z);
+		x[0] = _mm_unpacklo_pd(xy0, xy1);
+		x[1] = _mm_unpackhi_pd(xy0, xy1);
+		x[2] = _mm_unpacklo_pd(zw0, zw1);
+		w[0] = _mm_loadu_pd(&v[0].x);
+		w[1] = _mm_loadu_pd(&v[1].x);
+		w[2] = _mm_unpacklo_pd(_mm_loadu_pd(&v[0].z),
+		       _mm_loadu_pd(&v[1].z));
+		x[0] = wrap2_pd(x[0], _mm_unpacklo_pd(w[0], w[1]), f, &b[0]);
+		x[1] = wrap2_pd(x[1], _mm_unpackhi_pd(w[0], w[1]), f, &b[1]);
+		x[2] = wrap2_pd(x[2], w[2], f, &b[2]);
+		_mm_storeu_pd(&p[0].x, _mm_unpacklo_pd(x[0], x[1]));
+		_mm_storeu_pd(&p[1].x, _mm_unpackhi_pd(x[0], x[1]));
+		_mm_storeu_pd(&p[0].z, _mm_shuffle_pd(x[2], zw0, 2));
+		_mm_storeu_pd(&p[1].z, _mm_shuffle_pd(x[2], zw1, 3));
+	}
+
+	integrate_wrap_scalar(p, v, n % 2, step, center);
+	return;
+}
+#endif // HAVE_X86_KERNELS
+#endif // AST_FLOAT32
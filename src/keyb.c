@@ -28,85 +28,44 @@
 
 static inline void toggle_int_flag(int *);
 
-// Define the keyboard map
-KeyboardMap keymap = {
-	.asteroid_texture_toggle    = 'm',
-	.auto_target_asteroid       = 'b', // was '\t'
-	.axes_toggle                = '$',
-	.crosshair_toggle           = '+',
-	.draw_dust_toggle           = '(',
-	.draw_shield_toggle         = ')',
-	.draw_torp_lensflare_toggle = '*',
-	.draw_tracer_toggle         = '_',
-	.end_game                   = 27 /* == '\e' */,
-	.fire_torp                  = ' ',
-	.headlight_toggle           = '[',
-	.nebula_texture_toggle      = 'k',
-	.pause                      = 'p',
-	.play_sound_toggle          = '#',
-	.reverse_mouse_x_toggle     = '!',
-	.reverse_mouse_y_toggle     = '@',
-	.rot_aboutx_ccw             = '2',
-	.rot_aboutx_cw              = '8',
-	.rot_abouty_ccw             = '4',
-	.rot_abouty_cw              = '6',
-	.rot_aboutz_ccw             = 'e',
-	.rot_aboutz_cw              = 'q',
-	.slide_backward             = 'w', // was 'v'
-	.slide_down                 = 'x', // was 't'
-	.slide_forward              = 's', // was 'r'
-	.slide_left                 = 'a', // was 'd'
-	.slide_right                = 'd', // was 'g'
-	.slide_up                   = 'c',
-	.stop                       = 'f',
-	.target_asteroid            = '\t', // was 'b'
-	.torp_texture_toggle        = 'o',
-};
-KeyboardMap keymap_old = {
-	.asteroid_texture_toggle    = '&',
-	.auto_target_asteroid       = '\t',
-	.axes_toggle                = '$',
-	.crosshair_toggle           = '+',
-	.draw_dust_toggle           = '(',
-	.draw_shield_toggle         = ')',
-	.draw_torp_lensflare_toggle = '*',
-	.draw_tracer_toggle         = '_',
-	.end_game                   = 27 /* == '\e' */,
-	.fire_torp                  = ' ',
-	.headlight_toggle           = '[',
-	.nebula_texture_toggle      = '^',
-	.pause                      = 'p',
-	.play_sound_toggle          = '#',
-	.reverse_mouse_x_toggle     = '!',
-	.reverse_mouse_y_toggle     = '@',
-	.rot_aboutx_ccw             = '2',
-	.rot_aboutx_cw              = '8',
-	.rot_abouty_ccw             = '4',
-	.rot_abouty_cw              = '6',
-	.rot_aboutz_ccw             = '9',
-	.rot_aboutz_cw              = '7',
-	.slide_backward             = 'v',
-	.slide_down                 = 't',
-	.slide_forward              = 'r',
-	.slide_left                 = 'd',
-	.slide_right                = 'g',
-	.slide_up                   = 'c',
-	.stop                       = 'f',
-	.target_asteroid            = 'b',
-	.torp_texture_toggle        = '%',
-};
-
 // These are used for scaling keyboard rotation input
 int keyb_rotx_scalar = 0, keyb_roty_scalar = 0, keyb_rotz_scalar = 0;
 
 //-----------------------------------------------------------------------------
+/* Runs on the main thread. Keys that act on GLUT or GL, and the toggles
+only display() reads, are handled here; all others are passed on to the sim
+thread, see apply_key(). */
 void keyboard_handler(unsigned char key, int x, int y)
 {
 	if (key == keymap.end_game)
 		end_game();
 	else if (key == keymap.pause)
 		start_pause();
-	else if (key == keymap.slide_forward)
+	else if (key == keymap.headlight_toggle)
+		toggle_headlight();
+	else if (key == keymap.crosshair_toggle)
+		toggle_int_flag(&optmap.crosshair_flag);
+	else if (key == keymap.draw_dust_toggle)
+		toggle_int_flag(&optmap.draw_dust_flag);
+	else if (key == keymap.draw_torp_lensflare_toggle)
+		toggle_int_flag(&optmap.draw_torp_lensflare_flag);
+	else if (key == keymap.asteroid_texture_toggle)
+		toggle_int_flag(&optmap.texture_flag);
+	else if (key == keymap.nebula_texture_toggle)
+		toggle_int_flag(&optmap.nebula_texture_flag);
+	else if (key == keymap.torp_texture_toggle)
+		toggle_int_flag(&optmap.torp_texture_flag);
+	else if (key == keymap.axes_toggle)
+		toggle_int_flag(&optmap.axes_flag);
+	else
+		post_input_event(INPUT_KEY, key, x, y);
+	return;
+}
+
+/* Called by the sim thread for each key posted by keyboard_handler() */
+void apply_key(unsigned char key)
+{
+	if (key == keymap.slide_forward)
 		slide_alongz(MAX_TINPUT);
 	else if (key == keymap.slide_backward)
 		slide_alongz(-MAX_TINPUT);
@@ -138,34 +97,21 @@ void keyboard_handler(unsigned char key, int x, int y)
 	else if (key == keymap.rot_aboutz_ccw)
 		(keyb_rotz_scalar == 0) ? keyb_rotz_scalar = -4 :
 		                          --keyb_rotz_scalar;
-	else if (key == keymap.headlight_toggle)
-		toggle_headlight();
 	else if (key == keymap.target_asteroid)
 		target_asteroid();
 	else if (key == keymap.auto_target_asteroid)
 		auto_target_asteroid();
 	else if (key == keymap.fire_torp)
 		fire_torpedo();
-	else if (key == keymap.crosshair_toggle)
-		toggle_int_flag(&optmap.crosshair_flag);
 	else if (key == keymap.draw_tracer_toggle)
 		toggle_int_flag(&optmap.draw_tracer_flag);
 	else if (key == keymap.draw_shield_toggle)
+		/* display() gets it through the snapshot */
 		toggle_int_flag(&optmap.draw_shield_flag);
-	else if (key == keymap.draw_dust_toggle)
-		toggle_int_flag(&optmap.draw_dust_flag);
-	else if (key == keymap.draw_torp_lensflare_toggle)
-		toggle_int_flag(&optmap.draw_torp_lensflare_flag);
-	else if (key == keymap.asteroid_texture_toggle)
-		toggle_int_flag(&optmap.texture_flag);
-	else if (key == keymap.nebula_texture_toggle)
-		toggle_int_flag(&optmap.nebula_texture_flag);
-	else if (key == keymap.torp_texture_toggle)
-		toggle_int_flag(&optmap.torp_texture_flag);
-	else if (key == keymap.axes_toggle)
-		toggle_int_flag(&optmap.axes_flag);
 	else if (key == keymap.play_sound_toggle)
 		toggle_int_flag(&optmap.play_sound_flag);
+	else if (key == keymap.rock_collision_toggle)
+		toggle_int_flag(&optmap.rock_collision_flag);
 	else if (key == keymap.reverse_mouse_x_toggle)
 		optmap.mouse_xdir *= -1;
 	else if (key == keymap.reverse_mouse_y_toggle)
@@ -34,18 +34,11 @@
 #include "asteroids3D.h"
 #include "config.h"
 
-/* The code which generates data for rendering will cycle some number of ticks
-per second.
-On a "slow" computer, this code will go slower than the number of ticks per
-second. The limiting factor should always be the time to render, however.
-On a "fast" computer, this code will cycle no faster than ticks per second, so
-the game should never be un-playable on a "fast" computer. */
-#define TPS 60.0
-
 static void display_copyright_on_terminal(void);
+static void end_stage(unsigned int);
 static void glut_initialization(int *, char **);
 static void gl_initialization(void);
-static void idle(void);
+static void load_sounds(void *);
 static void my_initialization(void);
 static void parse_command_line(int, char **);
 static void reshape(int, int);
@@ -55,42 +48,45 @@ static void reshape(int, int);
  **/
 
 
-/* Flags for internal program control */
-int mouse_roty_flag = 0;        /* set to 1 if the mouse has been moved out of the dead zone to rotate the ship about the y axis */
-int mouse_rotx_flag = 0;        /* set to 1 if the mouse has been moved out of the dead zone to rotate the ship about the x axis */
-int game_end_flag = 0;          /* is the game over */
-
-/* track the mouse cursor */
+/* track the mouse cursor, for drawing it */
 int mouse_x, mouse_y;
 
-/* the proportion the mouse has moved out of the dead zone */
-double mouse_xprop = 0;
-double mouse_yprop = 0;
-
-/* the number of game time ticks that have past */
-unsigned long ticks = 0;
-
-/* dt = delta time, the amount of time (in seconds)
- *  which passes with each game tick
- */
-double dt = 1.0 / TPS;
-
-/* this is the number of ticks per second, which I may want to change dynamically */
-double tps = TPS;
-
-/* frame calculation thread id, and the run_yield
- * mutex for interleaving calculation and display updates
+/* frame calculation thread id, and the run_yield mutex the sim thread
+ * holds while it runs a tick. display() draws from render snapshots and
+ * does not take it, see snapshot.c.
  */
 pthread_mutex_t run_yield = PTHREAD_MUTEX_INITIALIZER;
 static pthread_t fc_tid;
 
-// Dead zone boundaries */
-static int mouse_left_bound, mouse_right_bound, mouse_top_bound,
-	mouse_bottom_bound;
+/* Seed of all random number streams, from -seed or the clock */
+static unsigned long long seed;
+
+/* Threads in the job system, 0 = one per CPU */
+static unsigned int num_threads = 0;
+
+/* Number of ticks to run the benchmark for, 0 = play the game */
+static unsigned int bench_ticks = 0;
+
+/* Stages of the main thread from the start to the first frame, and when
+each ended, see print_startup_times() */
+#define STAGE_WINDOW  0
+#define STAGE_WORLD   1
+#define STAGE_MODELS  2
+#define STAGE_WAIT    3
+#define STAGE_UPLOAD  4
+#define STAGE_FRAME   5
+#define NUM_STAGES    6
+static const char *const stage_name[] =
+	{"window", "world", "display lists", "waiting for files",
+	"texture upload", "first frame"};
+static double start_time, stage_end[NUM_STAGES];
+static double sound_secs; // time load_sounds() took
 
 //-----------------------------------------------------------------------------
 int main(int argc, char **argv)
 {
+	struct timespec now;
+
 #ifdef DATADIR
 	if (chdir(DATADIR) != 0) {
 		fprintf(stderr, "Could not chdir to %s: %s\n",
@@ -98,12 +94,21 @@ int main(int argc, char **argv)
 		return EXIT_FAILURE;
 	}
 #endif
-	srand(time(NULL));
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	start_time = now.tv_sec + now.tv_nsec / 1e9;
+	seed = time(NULL);
 	parse_command_line(argc, argv);
 	display_copyright_on_terminal();
+	printf("Random seed: %llu (replay with -seed)\n", seed);
+	rng_seed(seed);
 	read_rcfile();
+	init_workers(num_threads);
+	if (bench_ticks > 0) {
+		return run_benchmark(bench_ticks) ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
 	glut_initialization(&argc, argv);
 	gl_initialization();
+	end_stage(STAGE_WINDOW);
 	my_initialization();
 	glutMainLoop();
 	return EXIT_SUCCESS;
@@ -120,9 +125,9 @@ static void glut_initialization(int *argc, char **argv)
 	glutDisplayFunc(display);
 	glutMouseFunc(mouse_handler);
 	glutKeyboardFunc(keyboard_handler);
-	glutIdleFunc(idle);
 	glutReshapeFunc(reshape);
 	glutPassiveMotionFunc(passive_mouse_handler);
+	init_pacer();
 
 	/* center the mouse cursor -- see glutPassiveMouseFunc */
 	glutWarpPointer(optmap.windowx / 2, optmap.windowy / 2);
@@ -147,76 +152,124 @@ static void gl_initialization(void)
 	return;
 }
 
+/*
+ * Startup goes in two lines. The texture and sound files are read and
+decoded as jobs, while the main thread, which has the GL context, builds
+the world and the display lists. The textures are uploaded once both are
+done.
+ */
 static void my_initialization(void)
 {
+	struct timespec now;
+	Job *loads;
+
 	printf("Initializing...\n");
+	loads = create_job(NULL, NULL, NULL);
+	load_textures(loads);
+	submit_job(create_job(load_sounds, NULL, loads));
+	submit_job(loads);
+
 	reset_view();
+	gl_load_view();
 	gl_init_light();
 	gl_init_headlight(); /* reset_view() must be called before gl_init_headlight */
 	init_thrust();
 	init_torps();
-	init_textures();
+	rng_select(RNG_SIM); /* the world comes from the stream the sim goes on with */
 	init_asteroids();
+	rng_select(RNG_RENDER);
+	init_snapshots();
+	end_stage(STAGE_WORLD);
+
 	init_shield();
 	init_hud();
 	init_sun(); /* must be called after  gl_init_light */
 	init_explosions();
+	init_models(); /* display lists of the above */
 	init_dust();
 	init_target_dls();
-	init_nebula_billboards(); /* must be called after  gl_init_light, and init_textures */
 	init_wind_parts();
-	init_sound();
 	init_lens_flares();
 	init_debug();
+	init_instancing(); /* must be called after init_models */
+	end_stage(STAGE_MODELS);
+
+	wait_job(loads);
+	end_stage(STAGE_WAIT);
+	init_textures();
+	init_nebula_billboards(); /* must be called after  gl_init_light, and init_textures */
+	end_stage(STAGE_UPLOAD);
 
-	/* finally, and always last,
-	 * set up the run_yield semaphore and
-	 * crank up the frame calculation thread
+	/* finally, and always last, give display() a first snapshot
+	 * to draw and crank up the frame calculation thread
 	 */
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	publish_snapshot(now.tv_sec + now.tv_nsec / 1e9);
 	pthread_create(&fc_tid, NULL, calculate_frame, NULL);
 	printf("Done.\n");
 	return;
 }
 
-static void idle(void)
+/* Job: open the sound device and read the sounds */
+static void load_sounds(void *unused)
 {
-	/* calculate_frame() is now a thread by itself, hope this works */
-	/* calculate_frame(); */
-	glutPostRedisplay();
+	struct timespec t0, t1;
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	init_sound();
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	sound_secs = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+	return;
+}
+
+/* Note the time a startup stage ended */
+static void end_stage(unsigned int stage)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	stage_end[stage] = now.tv_sec + now.tv_nsec / 1e9;
+	return;
+}
+
+/* Print how long it took to get to the first frame, by stage. Called by
+display() once that is drawn. */
+void print_startup_times(void)
+{
+	double prev = start_time;
+	unsigned int s;
+
+	end_stage(STAGE_FRAME);
+	printf("First frame after %.1f ms:\n",
+	       (stage_end[STAGE_FRAME] - start_time) * 1000);
+	for (s = 0; s < NUM_STAGES; ++s) {
+		printf("  %-18s %7.1f ms\n", stage_name[s],
+		       (stage_end[s] - prev) * 1000);
+		prev = stage_end[s];
+	}
+	printf("  (meanwhile, sounds read in %.1f ms by a job)\n",
+	       sound_secs * 1000);
 	return;
 }
 
 static void reshape(int w, int h)
 {
-	unsigned int m;
 	glViewport(0, 0, w, h);
 
 	optmap.windowx = w;
 	optmap.windowy = h;
-
-	m = optmap.windowx / 2;
-	mouse_left_bound  = m - 50;
-	mouse_right_bound = m + 50;
-	m = optmap.windowy / 2;
-	mouse_top_bound = m - 50;
-	mouse_bottom_bound = m + 50;
+	post_input_event(INPUT_RESIZE, 0, w, h);
 	return;
 }
 
+/* The mouse and keyboard callbacks leave all changes to the game to the sim
+thread, see input.c */
 void mouse_handler(int button, int state, int x, int y)
 {
 	/* mouse x,y are given in window coordinates
 	 */
-	switch (button) {
-		case GLUT_LEFT_BUTTON:
-			if (state == GLUT_DOWN)
-				fire_torpedo();
-			break;
-		case GLUT_RIGHT_BUTTON:
-			if (state == GLUT_DOWN)
-				target_asteroid();
-			break;
-	}
+	if (state == GLUT_DOWN)
+		post_input_event(INPUT_BUTTON, button, x, y);
 	return;
 }
 
@@ -225,47 +278,30 @@ void passive_mouse_handler(int x, int y)
 	/* set the mouse position globals */
 	mouse_x = x;
 	mouse_y = y;
-
-	/* if mouse is inside dead zone */
-	if (x > mouse_left_bound && x < mouse_right_bound &&
-	    y > mouse_top_bound && y < mouse_bottom_bound) {
-		mouse_roty_flag = 0;
-		mouse_rotx_flag = 0;
-		return;
-	}
-
-	/* if mouse is not in the dead zone set the flag */
-	if (x > mouse_right_bound) {
-		mouse_roty_flag = 1;
-		mouse_yprop = static_cast(double, x - mouse_right_bound) /
-		              (optmap.windowx - mouse_right_bound);
-	}
-
-	if (x < mouse_left_bound) {
-		mouse_roty_flag = 1;
-		mouse_yprop = -1 + static_cast(double, x) / mouse_left_bound;
-	}
-
-	if (y < mouse_top_bound) {
-		mouse_rotx_flag = 1;
-		mouse_xprop = 1 - static_cast(double, y) / mouse_top_bound;
-	}
-
-	if (y > mouse_bottom_bound) {
-		mouse_rotx_flag = 1;
-		mouse_xprop = static_cast(double, -(y - mouse_bottom_bound)) /
-		              (optmap.windowy - mouse_bottom_bound);
-	}
-
-	/* for reversing mouse direction */
-	mouse_yprop = mouse_yprop * optmap.mouse_ydir;
-	mouse_xprop = mouse_xprop * optmap.mouse_xdir;
+	post_input_event(INPUT_MOTION, 0, x, y);
 	return;
 }
 
+/* Called by either thread. The sim thread leaves calculate_frame() at its
+next tick, and the main thread then calls finish_game(). */
 void end_game(void)
 {
 	game_end_flag = 1;  /* this causes the calculation thread to exit */
+	return;
+}
+
+/* Runs on the main thread once the game has ended, see pace_frame(). The
+stats belong to the sim, so they are printed after its thread is gone. */
+void finish_game(void)
+{
+	pthread_join(fc_tid, NULL);
+	print_asteroid_pool_stats();
+	print_spawn_stats();
+	print_lod_stats();
+	print_collision_stats();
+	print_frame_stats();
+	print_input_stats();
+	print_worker_stats();
 	init_score_display();
 	return;
 }
@@ -274,6 +310,7 @@ static void parse_command_line(int argc, char **argv)
 {
 	int i;
 	int temp1, temp2, temp3, temp4;
+	double temp5;
 
 	for (i = 0; i < argc; ++i) {
 		if (strcmp("-help", argv[i]) == 0 ||
@@ -284,6 +321,21 @@ static void parse_command_line(int argc, char **argv)
 			printf("valid command line options:\n") ;
 			printf("   -num <number>\n"
 			       "         to set the number of asteroids\n\n") ;
+			printf("   -maxast <number>\n"
+			       "         to set the most asteroids alive at once (default: 4 * num)\n\n") ;
+			printf("   -seed <number>\n"
+			       "         to replay the game started with this random seed\n\n") ;
+			printf("   -tps <number>\n"
+			       "         to set the ticks per second of the game (default: %.0f);\n"
+			       "         frames are blended between ticks, see the interpolate option\n\n",
+			       tps);
+			printf("   -fps <number>\n"
+			       "         to draw at most <number> frames per second, 0 = no limit\n\n") ;
+			printf("   -threads <number>\n"
+			       "         to run the job system on <number> threads (default: one per CPU)\n\n") ;
+			printf("   -bench <ticks>\n"
+			       "         to time <ticks> ticks of the asteroid field without a window,\n"
+			       "         once for each number of worker threads\n\n") ;
 			printf("   -geometry <width>x<height>+<xoffset>+<yoffset>\n"
 			       "         to set the geometry of the window (in pixels); e.g. 640x480+150+50\n\n");
 			printf("   -rcfile <filename>\n"
@@ -301,6 +353,53 @@ static void parse_command_line(int argc, char **argv)
 					++i;
 				}
 			}
+		} else if (strcmp("-maxast", argv[i]) == 0) {
+			if (i + 1 < argc) {
+				if (sscanf(argv[i+1], "%d\n", &temp1) == 1) {
+					if (temp1 > 0)
+						optmap.max_asteroids = temp1;
+					++i;
+				}
+			}
+		} else if (strcmp("-seed", argv[i]) == 0) {
+			if (i + 1 < argc) {
+				if (sscanf(argv[i+1], "%llu\n", &seed) == 1)
+					++i;
+			}
+		} else if (strcmp("-tps", argv[i]) == 0) {
+			if (i + 1 < argc) {
+				if (sscanf(argv[i+1], "%lf\n", &temp5) == 1) {
+					if (temp5 > 0) {
+						tps = temp5;
+						dt  = 1 / tps;
+					}
+					++i;
+				}
+			}
+		} else if (strcmp("-fps", argv[i]) == 0) {
+			if (i + 1 < argc) {
+				if (sscanf(argv[i+1], "%d\n", &temp1) == 1) {
+					if (temp1 >= 0)
+						optmap.max_fps = temp1;
+					++i;
+				}
+			}
+		} else if (strcmp("-threads", argv[i]) == 0) {
+			if (i + 1 < argc) {
+				if (sscanf(argv[i+1], "%d\n", &temp1) == 1) {
+					if (temp1 > 0)
+						num_threads = temp1;
+					++i;
+				}
+			}
+		} else if (strcmp("-bench", argv[i]) == 0) {
+			if (i + 1 < argc) {
+				if (sscanf(argv[i+1], "%d\n", &temp1) == 1) {
+					if (temp1 > 0)
+						bench_ticks = temp1;
+					++i;
+				}
+			}
 		} else if (strcmp("-geometry", argv[i]) == 0) {
 			if (i + 1 < argc) {
 				if (sscanf(argv[i+1], "%dx%d+%d+%d\n", &temp1, &temp2, &temp3, &temp4) >= 2) {
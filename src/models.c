@@ -0,0 +1,495 @@
+/* Asteroids3D - a first person game of blowing up asteroids
+ * Copyright (C) 2000 Stuart Mark Pomerantz <smp [at] psc edu>
+ * Copyright © Jan Engelhardt <jengelh [at] gmx de>, 2003 - 2006
+ *
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  Stuart Pomerantz
+ *  3935 Stonecliffe drive
+ *  Monroeville, PA 15146
+ */
+
+/*
+ * Display lists of the simulated objects: asteroids, explosions, the shield
+and torpedos. They are built here rather than next to the simulation code so
+that the simulation modules link without GL (see sim_main.c).
+ */
+
+#include <GL/glut.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "asteroids3D.h"
+#include "vecops.h"
+
+static void compile_ast_dl(int, const RockMesh *);
+static void fan_triangles(RockMesh *, unsigned int);
+static void gen_rand_ast(double, RockMesh *);
+static void gen_rand_explosion_particles(int, int, double, int);
+static void init_asteroid_dls(void);
+static void init_explosion_dl(void);
+static void init_explosion_winshield_particle_dl(void);
+static void init_shield_dl(void);
+static void init_torpedo_dls(void);
+static void mesh_center(RockMesh *, double);
+static void mesh_vertex(RockMesh *, const Vector *, double, double);
+static void strip_triangles(RockMesh *, unsigned int);
+
+/* Asteroid shapes, and a display list of each */
+RockMesh ast_mesh[NUM_AST_TYPES];
+int ast_dl[NUM_AST_TYPES];
+
+/* Asteroid texture object list */
+unsigned int ast_tex[NUM_AST_TYPES];
+
+int expl_dl[NUM_BLAST_TYPES];
+int expl_winshield_particle_dl;
+int shield_dl;         // shield display list
+int torp_dl;           // torpedo display list
+int torp_billboard_dl; // billboard for torpedo texture
+unsigned int torp_tex; // torpedo billboard texture
+
+//-----------------------------------------------------------------------------
+void init_models(void)
+{
+	init_asteroid_dls();
+	init_explosion_dl();
+	init_explosion_winshield_particle_dl();
+	init_shield_dl();
+	init_torpedo_dls();
+	return;
+}
+
+static void init_asteroid_dls(void)
+{
+	double k = 0.5;
+	int i;
+
+	for (i = 0; i < NUM_AST_TYPES; ++i) {
+		gen_rand_ast(0.2, &ast_mesh[i]);
+		ast_mesh[i].scale = k;
+		ast_dl[i] = glGenLists(1);
+		compile_ast_dl(ast_dl[i], &ast_mesh[i]);
+		k += 0.5;
+	}
+
+	return;
+}
+
+/* The state every asteroid is drawn with, whichever way */
+void gl_ast_material(void)
+{
+	static const float ad[] = {1, 1, 1, 1};
+
+	glShadeModel(GL_FLAT);
+	glMaterialfv(GL_FRONT, GL_AMBIENT_AND_DIFFUSE, ad);
+	return;
+}
+
+static void compile_ast_dl(int dl, const RockMesh *m)
+{
+	const RockVertex *v;
+	unsigned int i;
+
+	glNewList(dl, GL_COMPILE);
+	gl_ast_material();
+	glScalef(m->scale, m->scale, m->scale);
+	glBegin(GL_TRIANGLES);
+	for (i = 0; i < m->num_indices; ++i) {
+		v = &m->vertex[m->index[i]];
+		glNormal3fv(v->normal);
+		glTexCoord2fv(v->tc);
+		glVertex3fv(v->pos);
+	}
+	glEnd();
+	glEndList();
+	return;
+}
+
+/* Generate a random asteroid shape into m, as triangles. It is a sphere
+of unit radius whose points have been moved by up to pert along each axis. */
+static void gen_rand_ast(double pert, RockMesh *m)
+{
+#define P_SLICES 8
+#define T_SLICES 8
+	double phi, theta;
+	double delta_p = M_PI / P_SLICES;
+	double delta_t = 2 * M_PI / T_SLICES;
+	int rows = P_SLICES - 1;
+	int cols = T_SLICES;
+	int i, j;
+	Vector sphere[P_SLICES - 1][T_SLICES];
+	double q = pert;
+	double tc[P_SLICES - 1][T_SLICES][2] ; /* these last variables are for texture coords */
+	double dts = 2.0 / rows, dtt = 4.0 / cols;
+	double s, t;
+	int side, side_len;
+	unsigned int first;
+
+	/* the body is a quad strip of two vertices per point of rows - 1
+	 * circles and the two closing the circle, each end a triangle fan */
+	m->num_vertices = m->num_indices = 0;
+	m->vertex = malloc(((rows - 1) * (cols + 1) * 2 + 2 * (cols + 2)) *
+	            sizeof(RockVertex));
+	m->index  = malloc(((rows - 1) * (cols + 1) * 6 + 2 * 3 * cols) *
+	            sizeof(unsigned short));
+	if (m->vertex == NULL || m->index == NULL) {
+		perror("malloc");
+		exit(EXIT_FAILURE);
+	}
+
+	/* generate the points on the sphere and load them into a data structure
+	 *
+	 * This whole algorithm below makes sense if you know that theta
+	 * generates circles of points and phi moves from one end of the sphere
+	 * to the other modulating the radius of the circles generated by theta.
+	 *
+	 * so, each circular slice through the sphere is represented by "i" and
+	 * each point on a particular circle is represented by "j"
+	 *
+	 * use GL_LINE_LOOP instead of GL_QUAD_STRIP to display the sphere and you'll
+	 * see what I mean.
+	 */
+
+	s = 0;
+	for (i = 0, phi = delta_p; i < rows; phi += delta_p, ++i) {
+		double sinphi = sin(phi), cosphi = cos(phi);
+		t = 0;
+		for (j = 0, theta = 0; j < cols; theta += delta_t, ++j) {
+			sphere[i][j].x = cos(theta) * sinphi;
+			sphere[i][j].y = sin(theta) * sinphi;
+			sphere[i][j].z = cosphi;
+			tc[i][j][0] = s;
+			tc[i][j][1] = t;
+			t += dtt;
+		}
+		s += dts;
+	}
+
+	/* randomly perturb the points q = 0.1 is good */
+	for (i = 0, phi = delta_p; i < rows; phi += delta_p, ++i)
+		for (j = 0, theta = 0; j < cols; theta += delta_t, ++j) {
+			sphere[i][j].x += gen_rand_float(-q, q);
+			sphere[i][j].y += gen_rand_float(-q, q);
+			sphere[i][j].z += gen_rand_float(-q, q);
+		}
+
+	/* asteroid body */
+	for (i = 0, phi = delta_p; i < rows - 1; phi += delta_p, ++i) {
+		for (j = 0, theta = 0; j < cols; theta += delta_t, ++j) {
+			mesh_vertex(m, &sphere[i][j], tc[i][j][0], tc[i][j][1]);
+			mesh_vertex(m, &sphere[i+1][j], tc[i+1][j][0],
+			            tc[i+1][j][1]);
+		}
+
+		mesh_vertex(m, &sphere[i][0], tc[i][j-1][0] + dts,
+		            tc[i][j-1][1] + dtt);
+		mesh_vertex(m, &sphere[i+1][0], tc[i+1][j-1][0] + dts,
+		            tc[i+1][j-1][1] + dtt);
+	}
+	strip_triangles(m, 0);
+	/* asteroid ends */
+
+	/* generate the texture coords for this asteroid end */
+	s = t = 0;
+	side = 0;
+	side_len = cols / 4;
+	dts = 1.0 / side_len;
+
+	for (i = 0; i < cols; ++i) {
+		tc[0][i][0] = s;
+		tc[0][i][1] = t;
+
+		if (i % side_len == 0)
+		    ++side;
+		if (side == 1)
+			s += dts;
+		if (side == 2)
+			t += dts;
+		if (side == 3)
+			s -= dts;
+		if (side == 4)
+			t -= dts;
+	}
+
+	first = m->num_vertices;
+	mesh_center(m, 1);
+	m->vertex[first].tc[0] = 0.5;
+	m->vertex[first].tc[1] = 0.5;
+	for (i = 0; i < cols; ++i)
+		mesh_vertex(m, &sphere[0][i], tc[0][i][0], tc[0][i][1]);
+	mesh_vertex(m, &sphere[0][0], tc[0][i-1][0], tc[0][i-1][1] - dts);
+	fan_triangles(m, first);
+
+	/* generate the texture coords for this asteroid end */
+	s = t = 0;
+	side = 0;
+	side_len = cols / 4;
+	dts = 1.0 / side_len;
+
+	for (i = 0; i < cols; ++i) {
+		tc[0][i][0] = s;
+		tc[0][i][1] = t;
+
+		if (i % side_len == 0)
+		    ++side;
+		if (side == 1)
+			s += dts;
+		if (side == 2)
+			t += dts;
+		if (side == 3)
+			s -= dts;
+		if (side == 4)
+			t -= dts;
+	}
+
+	first = m->num_vertices;
+	mesh_center(m, -1);
+	for (i = cols - 1; i >= 0; --i)
+		mesh_vertex(m, &sphere[rows-1][i], tc[rows-1][i][0],
+		            tc[rows-1][i][1]);
+	mesh_vertex(m, &sphere[rows-1][cols-1], tc[rows-1][cols-1][0],
+	            tc[rows-1][cols-1][1] + dts);
+	fan_triangles(m, first);
+	return;
+#undef P_SLICES
+#undef T_SLICES
+}
+
+/* Add a vertex at p, with the normal pointing away from the center */
+static void mesh_vertex(RockMesh *m, const Vector *p, double s, double t)
+{
+	RockVertex *v = &m->vertex[m->num_vertices++];
+	double len = vec_length(p);
+
+	v->pos[0]    = p->x;
+	v->pos[1]    = p->y;
+	v->pos[2]    = p->z;
+	v->normal[0] = p->x / len;
+	v->normal[1] = p->y / len;
+	v->normal[2] = p->z / len;
+	v->tc[0]     = s;
+	v->tc[1]     = t;
+	return;
+}
+
+/* Add the center of an end at (0, 0, z). It keeps the normal and texture
+coords of the vertex before, as the display list used to; under flat
+shading the normal of a center is never used anyway. */
+static void mesh_center(RockMesh *m, double z)
+{
+	RockVertex *v = &m->vertex[m->num_vertices];
+
+	*v = v[-1];
+	v->pos[0] = v->pos[1] = 0;
+	v->pos[2] = z;
+	++m->num_vertices;
+	return;
+}
+
+/* Triangles of the quad strip from vertex first to the last one. Each
+triangle ends with the vertex that gave its quad the normal under flat
+shading. */
+static void strip_triangles(RockMesh *m, unsigned int first)
+{
+	unsigned short *x;
+	unsigned int k;
+
+	for (k = first; k + 3 < m->num_vertices; k += 2) {
+		x = &m->index[m->num_indices];
+		x[0] = k;
+		x[1] = k + 1;
+		x[2] = k + 3;
+		x[3] = k + 2;
+		x[4] = k;
+		x[5] = k + 3;
+		m->num_indices += 6;
+	}
+	return;
+}
+
+/* Triangles of the fan around vertex first */
+static void fan_triangles(RockMesh *m, unsigned int first)
+{
+	unsigned short *x;
+	unsigned int k;
+
+	for (k = first + 1; k + 1 < m->num_vertices; ++k) {
+		x = &m->index[m->num_indices];
+		x[0] = first;
+		x[1] = k;
+		x[2] = k + 1;
+		m->num_indices += 3;
+	}
+	return;
+}
+
+static void init_explosion_dl(void)
+{
+	int i;
+
+	for (i = 0; i < NUM_BLAST_TYPES; ++i) {
+		expl_dl[i] = glGenLists(1);
+		gen_rand_explosion_particles(15 + i, 15 + i, 0.5, expl_dl[i]);
+	}
+	return;
+}
+
+static void gen_rand_explosion_particles(int ps, int ts, double pert, int dl)
+{
+	double phi, theta;
+	int p_slices = ps;
+	int t_slices = ts;
+	double delta_p = M_PI / p_slices;
+	double delta_t = 2 * M_PI / t_slices;
+	int rows = p_slices - 1;
+	int cols = t_slices;
+	int i, j;
+	double q = pert;
+
+	/*
+	 * This is the same code that generates the randomly perturbed sphere which
+	 * I turned into an asteroid. What was that you said about applying the
+	 * same trick again and again, Dr. Wetzel ? :-)
+	 *
+	 */
+	glNewList(dl, GL_COMPILE);
+	glPointSize(1);
+	glBegin(GL_POINTS);
+
+	for (i = 0, phi = delta_p; i < rows; phi += delta_p, ++i) {
+		double sinphi = sin(phi), cosphi = cos(phi);
+
+		for (j = 0, theta = 0; j < cols; theta += delta_t, ++j)
+			glVertex3f(cos(theta) * sinphi + gen_rand_float(-q, q),
+			           sin(theta) * sinphi + gen_rand_float(-q, q),
+			           cosphi + gen_rand_float(-q, q));
+	}
+
+	glEnd();
+	glEndList();
+	return;
+}
+
+static void init_explosion_winshield_particle_dl(void)
+{
+	static const float emit_on[]  = {0.0, 0.6, 0.0, 1.0};
+	static const float emit_off[] = {0.0, 0.0, 0.0, 1.0};
+	static const float ad[]       = {0.0, 0.0, 0.0, 0.5};
+	double t;
+
+	expl_winshield_particle_dl = glGenLists(1);
+	glNewList(expl_winshield_particle_dl, GL_COMPILE);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glMaterialfv(GL_FRONT, GL_AMBIENT_AND_DIFFUSE, ad);
+	glMaterialfv(GL_FRONT, GL_EMISSION, emit_on);
+	glBegin(GL_TRIANGLE_FAN);
+	glVertex3f(0, 0, 0);
+	for (t = 0; t < 2 * M_PI + M_PI / 10; t += M_PI / 10)
+		glVertex3f(0.01 * cos(t), 0.01 * sin(t), 0);
+	glEnd();
+	glMaterialfv(GL_FRONT, GL_EMISSION, emit_off);
+	glDisable(GL_BLEND);
+	glEndList();
+	return;
+}
+
+static void init_shield_dl(void)
+{
+	static const float emit0[]    = {0.0, 0.6, 0.0, 1.0};
+	static const float ad0[]      = {0.0, 0.0, 0.0, 0.5};
+	static const float emit_off[] = {0.0, 0.0, 0.0, 1.0};
+	static const float width = 2.0, height = 2.0; /* width and height should be chosen to cover window */
+
+	shield_dl = glGenLists (1);
+	glNewList (shield_dl, GL_COMPILE);
+		glEnable(GL_BLEND) ;
+		glBlendFunc(GL_SRC_ALPHA,GL_ONE_MINUS_SRC_ALPHA) ;
+		glMaterialfv(GL_FRONT,GL_EMISSION,emit0) ;
+		glMaterialfv(GL_FRONT,GL_AMBIENT_AND_DIFFUSE,ad0) ;
+		glPushMatrix() ;
+			glLoadIdentity() ;
+			glTranslatef(0, 0, -2) ;
+			glBegin( GL_QUADS ) ;
+				glVertex3f(  width , height, 0.0 ) ;
+				glVertex3f( -width , height , 0.0 ) ;
+				glVertex3f( -width , -height , 0.0 ) ;
+				glVertex3f( width ,  -height , 0.0 ) ;
+			glEnd() ;
+		glPopMatrix() ;
+		glMaterialfv(GL_FRONT,GL_EMISSION,emit_off) ;
+		glDisable(GL_BLEND) ;
+	glEndList ();
+	return;
+}
+
+static void init_torpedo_dls(void)
+{
+	static const float emit0[]    = {1.0,  1.0, 1.0, 1.0}; /* torp material properties */
+	static const float ad0[]      = {0.0,  0.0, 0.0, 1.0};
+	static const float emit1[]    = {1.0,  1.0, 1.0, 1.0};
+	static const float ad1[]      = {0.0,  0.0, 0.0, 0.4};
+	static const float emit2[]    = {0.0,  0.6, 1.0, 1.0};
+	static const float ad2[]      = {0.0,  0.0, 0.0, 0.3};
+	static const float emit_off[] = {0.0 , 0.0, 0.0, 1.0};
+	static const float diffuse[]  = {0.0,  0.6, 1.0, 1.0}; /* tracer light property */
+	int k;
+
+	/* set up torpedo display list */
+	torp_dl = glGenLists(1);
+	glNewList(torp_dl, GL_COMPILE);
+		glShadeModel(GL_SMOOTH);
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		glMaterialfv(GL_FRONT, GL_AMBIENT_AND_DIFFUSE, ad0);
+		glMaterialfv(GL_FRONT, GL_EMISSION, emit0);
+		glutSolidSphere(TORP_RADIUS - 2 * TORP_RADIUS_DELTA, 10, 10);
+		glMaterialfv(GL_FRONT, GL_AMBIENT_AND_DIFFUSE, ad1);
+		glMaterialfv(GL_FRONT, GL_EMISSION, emit1);
+		glutSolidSphere(TORP_RADIUS - TORP_RADIUS_DELTA, 10, 10);
+		glMaterialfv(GL_FRONT, GL_AMBIENT_AND_DIFFUSE, ad2);
+		glMaterialfv(GL_FRONT, GL_EMISSION, emit2) ;
+		glutSolidSphere(TORP_RADIUS + TORP_RADIUS_DELTA, 10, 10);
+		glMaterialfv(GL_FRONT, GL_EMISSION, emit_off);
+		glMaterialfv(GL_FRONT, GL_AMBIENT_AND_DIFFUSE, emit_off);
+		glDisable(GL_BLEND);
+	glEndList();
+
+	/* set up the torpedo billboard */
+	k = 3; /* scaling factor */
+	torp_billboard_dl = glGenLists(1);
+	glNewList(torp_billboard_dl, GL_COMPILE);
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		glBegin(GL_QUADS);
+			glTexCoord2f(1, 0);
+			glVertex3f(k / 2, -k / 2, 0);
+			glTexCoord2f(1, 1);
+			glVertex3f(k / 2, k / 2, 0);
+			glTexCoord2f(0, 1);
+			glVertex3f(-k / 2, k / 2, 0);
+			glTexCoord2f(0, 0);
+			glVertex3f(-k / 2, -k / 2, 0);
+		glEnd();
+		glDisable(GL_BLEND);
+	glEndList();
+
+	/* set up tracer torpedo light properties */
+	glLightfv(GL_LIGHT2, GL_DIFFUSE, diffuse);
+	glLightf(GL_LIGHT2, GL_SPOT_CUTOFF, 50);
+	return;
+}
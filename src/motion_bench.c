@@ -0,0 +1,131 @@
+/* Asteroids3D - a first person game of blowing up asteroids
+ * Copyright (C) 2000 Stuart Mark Pomerantz <smp [at] psc edu>
+ * Copyright © Jan Engelhardt <jengelh [at] gmx de>, 2003 - 2006
+ *
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  Stuart Pomerantz
+ *  3935 Stonecliffe drive
+ *  Monroeville, PA 15146
+ */
+
+/*
+ * Microbenchmark of the integrate-and-wrap kernels in integrate.c, built by
+"make bench". Every kernel the CPU supports moves the same random field for
+the same number of ticks; the time per rock is printed and the final
+positions are compared with those of the scalar reference.
+ *
+ * usage: motion_bench [rocks [ticks]]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "asteroids3D.h"
+
+#define BENCH_STEP (1.0 / 60) // dt at the default tick rate
+
+static double run_kernel(IntegrateFunc, AstVec *, const AstVec *,
+	unsigned int, unsigned int);
+
+static const char *const kernel_names[] = {"scalar", "sse2", "avx2"};
+#define NUM_KERNEL_NAMES (sizeof(kernel_names) / sizeof(*kernel_names))
+
+//-----------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+	unsigned int rocks = 100000, num_ticks = 1000, i, k;
+	AstVec *start, *vel, *ref, *out;
+	double ns, ref_ns = 0;
+	IntegrateFunc func;
+
+	if (argc > 1)
+		rocks = strtoul(argv[1], NULL, 0);
+	if (argc > 2)
+		num_ticks = strtoul(argv[2], NULL, 0);
+
+	start = calloc(rocks, sizeof(AstVec));
+	vel   = calloc(rocks, sizeof(AstVec));
+	ref   = calloc(rocks, sizeof(AstVec));
+	out   = calloc(rocks, sizeof(AstVec));
+	if (start == NULL || vel == NULL || ref == NULL || out == NULL) {
+		fprintf(stderr, "Could not allocate room for %u asteroids\n",
+		        rocks);
+		return EXIT_FAILURE;
+	}
+
+	/* The same spread of positions and speeds as a new game. w is not
+	part of the motion and has to come through untouched. */
+	rng_seed(1);
+	for (i = 0; i < rocks; ++i) {
+		start[i].x = gen_rand_float(-ABOUND, ABOUND);
+		start[i].y = gen_rand_float(-ABOUND, ABOUND);
+		start[i].z = gen_rand_float(-ABOUND, ABOUND);
+		vel[i].x   = gen_rand_float(-MAX_APD, MAX_APD);
+		vel[i].y   = gen_rand_float(-MAX_APD, MAX_APD);
+		vel[i].z   = gen_rand_float(-MAX_APD, MAX_APD);
+		start[i].w = gen_rand_float(0, 1 << 30);
+		vel[i].w   = gen_rand_float(0, 1 << 30);
+	}
+
+	printf("%u asteroids, %u ticks, kernel in use: %s\n",
+	       rocks, num_ticks, init_integrate());
+	for (k = 0; k < NUM_KERNEL_NAMES; ++k) {
+		if ((func = integrate_kernel(kernel_names[k])) == NULL) {
+			printf("  %-6s  not available in this build or CPU\n",
+			       kernel_names[k]);
+			continue;
+		}
+		memcpy(out, start, rocks * sizeof(AstVec));
+		ns = run_kernel(func, out, vel, rocks, num_ticks);
+		if (k == 0) {
+			memcpy(ref, out, rocks * sizeof(AstVec));
+			ref_ns = ns;
+		}
+		printf("  %-6s  %6.3f ns/rock  %5.2fx  %s\n", kernel_names[k],
+		       ns, ref_ns / ns,
+		       (memcmp(out, ref, rocks * sizeof(AstVec)) == 0) ?
+		       "identical" : "DIFFERS from scalar");
+	}
+
+	free(start);
+	free(vel);
+	free(ref);
+	free(out);
+	return EXIT_SUCCESS;
+}
+
+/* Move the field for the given ticks, return nanoseconds per rock and tick.
+The center drifts a little each tick, like a moving player. */
+static double run_kernel(IntegrateFunc func, AstVec *p, const AstVec *v,
+    unsigned int n, unsigned int num_ticks)
+{
+	struct timespec t0, t1;
+	Vector center = {0, 0, 0, 0};
+	unsigned int i;
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (i = 0; i < num_ticks; ++i) {
+		func(p, v, n, BENCH_STEP, &center);
+		center.x += 0.1;
+		center.z -= 0.05;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	return ((t1.tv_sec - t0.tv_sec) * 1e9 +
+	        (t1.tv_nsec - t0.tv_nsec)) / (static_cast(double, n) * num_ticks);
+}
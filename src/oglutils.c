@@ -22,9 +22,7 @@
  *  Monroeville, PA 15146
  */
 
-#include <GL/glut.h>
 #include <math.h>
-#include <stdlib.h>
 #include "asteroids3D.h"
 #include "vecops.h"
 
@@ -158,71 +156,6 @@ void find_rotation_angles(const Vector *v, double *x, double *y)
 	return;
 }
 
-void gen_rand_vec(Vector *v)
-{
-	int x, y, z;
-	double m[16];
-	Vector a, u = {0, 0, 1, 0};
-
-	x = 359.0 * rand() / (RAND_MAX + 1.0);
-	y = 359.0 * rand() / (RAND_MAX + 1.0);
-	z = 359.0 * rand() / (RAND_MAX + 1.0);
-
-	/* set the axis a to be the x axis first */
-	a.x = 1;
-	a.y = 0;
-	a.z = 0;
-	a.w = 1;
-
-	/* rotate u */
-	find_rotation_mat(x, &a, m);
-	apply_v2m(&u, m);
-
-	/* set the axis a to be the y axis next */
-	a.x = 0;
-	a.y = 1;
-	a.z = 0;
-	a.w = 1;
-
-	/* rotate u */
-	find_rotation_mat(y, &a, m);
-	apply_v2m(&u, m);
-
-	/* set the axis a to be the z axis finally */
-	a.x = 0;
-	a.y = 0;
-	a.z = 1;
-	a.w = 1;
-
-	/* rotate u */
-	find_rotation_mat(z, &a, m);
-	apply_v2m(&u, m);
-
-	/* put the results back into v */
-	*v = u;
-	return;
-}
-
-/* generate random floats in .1 (tenth) increments */
-double gen_rand_float(double min, double max)
-{
-	double k, len = max - min;
-
-	/* generate a number between 0 and len*10 */
-	k = 10 * len * rand() / (RAND_MAX + 1.0);
-
-	/* scale the number back down */
-	k = k / 10.0 - fabs(min);
-
-	return k;
-}
-
-int gen_rand_int(int lo, int hi)
-{
-	return static_cast(int, static_cast(double, rand()) *
-	       (++hi - lo) / RAND_MAX) + lo;
-}
-
 void apply_v2m(Vector *v, const double *m)
 {
 	Vector a = *v;
@@ -0,0 +1,195 @@
+/* Asteroids3D - a first person game of blowing up asteroids
+ * Copyright (C) 2000 Stuart Mark Pomerantz <smp [at] psc edu>
+ * Copyright © Jan Engelhardt <jengelh [at] gmx de>, 2003 - 2006
+ *
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  Stuart Pomerantz
+ *  3935 Stonecliffe drive
+ *  Monroeville, PA 15146
+ */
+
+/*
+ * Frame pacing. Rather than an idle callback that has GLUT redraw as fast
+as it can loop, a timer asks for each frame when it is due, and GLUT sleeps
+in between. While playing, frames are due every 1/max_fps seconds, or back
+to back with no cap, when the swap interval (vsync) holds the rate. While
+paused, on the score screen, or with the window hidden or the mouse pointer
+outside it, there are only PACE_IDLE_FPS frames a second, and none at all
+while hidden.
+ *
+ * The CPU time of the whole process is added up for each of those states
+and printed per minute at exit, see print_pace_stats().
+ */
+
+#include <GL/glut.h>
+#include <GL/glx.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "asteroids3D.h"
+
+/* Frame rate while nobody is playing */
+#define PACE_IDLE_FPS 10
+
+/* States of the game as far as pacing goes */
+#define PACE_PLAYING    0
+#define PACE_PAUSED     1
+#define PACE_AWAY       2 // window hidden or the pointer outside it
+#define PACE_SCORES     3
+#define NUM_PACE_STATES 4
+
+static void account_time(void);
+static void pace_entry(int);
+static void pace_frame(int);
+static int pace_state(void);
+static void pace_visibility(int);
+static void print_pace_stats(void);
+static void set_swap_interval(int);
+
+static const char *const pace_state_name[] =
+	{"playing", "paused", "away", "high scores"};
+
+static int window_visible = 1, pointer_inside = 1;
+static double next_frame; // when the next frame is due, monotonic clock
+
+/* Time spent in each state, and when it was last added up */
+static double state_cpu[NUM_PACE_STATES], state_wall[NUM_PACE_STATES];
+static double last_cpu, last_wall;
+static int last_state = PACE_PLAYING;
+
+//-----------------------------------------------------------------------------
+/* Take over the redisplay from glutIdleFunc(). Must be called after the
+window has been created. */
+void init_pacer(void)
+{
+	set_swap_interval(optmap.vsync_flag);
+	glutVisibilityFunc(pace_visibility);
+	glutEntryFunc(pace_entry);
+	account_time();
+	next_frame = last_wall;
+	glutTimerFunc(0, pace_frame, 0);
+	atexit(print_pace_stats);
+	return;
+}
+
+static void pace_frame(int unused)
+{
+	double period;
+	int state;
+
+	account_time();
+	state = pace_state();
+	if (state == PACE_SCORES && last_state != PACE_SCORES)
+		finish_game();
+	last_state = state;
+
+	if (state == PACE_PLAYING)
+		period = (optmap.max_fps > 0) ? 1.0 / optmap.max_fps : 0;
+	else
+		period = 1.0 / PACE_IDLE_FPS;
+	if (window_visible)
+		glutPostRedisplay();
+
+	/* keep to the schedule, but do not try to make up for lost frames */
+	next_frame += period;
+	if (next_frame < last_wall)
+		next_frame = last_wall;
+	glutTimerFunc(ceil((next_frame - last_wall) * 1000), pace_frame, 0);
+	return;
+}
+
+static int pace_state(void)
+{
+	if (game_end_flag)
+		return PACE_SCORES;
+	if (paused())
+		return PACE_PAUSED;
+	if (!window_visible || !pointer_inside)
+		return PACE_AWAY;
+	return PACE_PLAYING;
+}
+
+/* Add the time since the last call to the state the game was in */
+static void account_time(void)
+{
+	struct timespec cpu, wall;
+	double c, w;
+
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu);
+	clock_gettime(CLOCK_MONOTONIC, &wall);
+	c = cpu.tv_sec + cpu.tv_nsec / 1e9;
+	w = wall.tv_sec + wall.tv_nsec / 1e9;
+	if (last_wall > 0) {
+		state_cpu[last_state]  += c - last_cpu;
+		state_wall[last_state] += w - last_wall;
+	}
+	last_cpu  = c;
+	last_wall = w;
+	return;
+}
+
+static void pace_visibility(int state)
+{
+	window_visible = state == GLUT_VISIBLE;
+	return;
+}
+
+static void pace_entry(int state)
+{
+	pointer_inside = state == GLUT_ENTERED;
+	return;
+}
+
+/* Have buffer swaps wait for that many vertical retraces, 0 = do not wait,
+through whichever GLX swap control extension there is */
+static void set_swap_interval(int interval)
+{
+	void (*proc)(void);
+
+	proc = glXGetProcAddressARB(reinterpret_cast(const GLubyte *,
+	       "glXSwapIntervalMESA"));
+	if (proc != NULL &&
+	    reinterpret_cast(int (*)(unsigned int), proc)(interval) == 0)
+		return;
+
+	/* SGI's extension knows no interval 0 */
+	proc = glXGetProcAddressARB(reinterpret_cast(const GLubyte *,
+	       "glXSwapIntervalSGI"));
+	if (interval > 0 && proc != NULL &&
+	    reinterpret_cast(int (*)(int), proc)(interval) == 0)
+		return;
+
+	fprintf(stderr, "Could not set the swap interval (vsync) to %d\n",
+	        interval);
+	return;
+}
+
+static void print_pace_stats(void)
+{
+	unsigned int s;
+
+	account_time();
+	printf("CPU time per minute of each state:\n");
+	for (s = 0; s < NUM_PACE_STATES; ++s)
+		if (state_wall[s] > 0)
+			printf("  %-12s %6.2f s over %.1f min\n",
+			       pace_state_name[s],
+			       60 * state_cpu[s] / state_wall[s],
+			       state_wall[s] / 60);
+	return;
+}
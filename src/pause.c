@@ -22,6 +22,7 @@
  */
 
 #include <GL/glut.h>
+#include <pthread.h>
 #include "asteroids3D.h"
 
 static void stop_pause(void);
@@ -31,6 +32,10 @@ static void paused_keyboard_handler(unsigned char, int, int);
 
 int paused_flag = 0; // is the game paused
 
+/* The sim thread sleeps on pause_cond while the game is paused */
+static pthread_mutex_t pause_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t pause_cond  = PTHREAD_COND_INITIALIZER;
+
 //-----------------------------------------------------------------------------
 /* this is just a simple function that checks the condition
  * of the paused flag and returns 0 if the game is unpaused,
@@ -47,7 +52,9 @@ int paused(void)
 
 void start_pause(void)
 {
+	pthread_mutex_lock(&pause_lock);
 	paused_flag = 1;
+	pthread_mutex_unlock(&pause_lock);
 /*	glutDisplayFunc(paused_display); */
 	glutMouseFunc(paused_mouse_handler);
 	glutKeyboardFunc(paused_keyboard_handler);
@@ -57,7 +64,10 @@ void start_pause(void)
 
 static void stop_pause(void)
 {
+	pthread_mutex_lock(&pause_lock);
 	paused_flag = 0;
+	pthread_cond_broadcast(&pause_cond);
+	pthread_mutex_unlock(&pause_lock);
 	glutDisplayFunc(display);
 	glutMouseFunc(mouse_handler);
 	glutKeyboardFunc(keyboard_handler);
@@ -65,6 +75,16 @@ static void stop_pause(void)
 	return;
 }
 
+/* Block until the game is no longer paused */
+void wait_while_paused(void)
+{
+	pthread_mutex_lock(&pause_lock);
+	while (paused_flag)
+		pthread_cond_wait(&pause_cond, &pause_lock);
+	pthread_mutex_unlock(&pause_lock);
+	return;
+}
+
 void paused_display(void)
 {
 	/* may want to do something here someday, but
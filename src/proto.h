@@ -30,27 +30,57 @@ extern "C" {
 /*
  *      ASTEROID.C
  */
-extern Node *add_node(void);
+extern int ast_alloc(void);
+extern int ast_alloc_n(unsigned int *);
+extern void ast_axis(Vector *, unsigned int);
+extern void ast_handle(Handle *, unsigned int);
+extern void ast_kill(unsigned int);
+extern void ast_load(unsigned int, Asteroid *);
+extern void ast_pos(Vector *, unsigned int);
+extern void ast_remove(unsigned int);
+extern int ast_resolve(Handle);
+extern void ast_set_pos(unsigned int, const Vector *);
+extern void ast_set_vel(unsigned int, const Vector *);
+extern void ast_store(unsigned int, const Asteroid *);
+extern void ast_vel(Vector *, unsigned int);
+extern void drop_target(void);
 extern void init_asteroids(void);
+extern int is_targeted(unsigned int);
+extern void print_asteroid_pool_stats(void);
+extern void print_lod_stats(void);
 extern void process_asteroid_motion(int);
+extern void process_deleted_ast(void);
 
-extern Node *al_head, *al_tail, *delete_next_ast[];
-extern int ast_dl[], num_asteroids_on_scanner;
-extern unsigned int ast_tex[];
+extern AsteroidField afield;
+extern Handle current_target;
+extern int num_asteroids_on_scanner;
 
 /*
  *      CALC_FRAME.C
  */
 extern void *calculate_frame(void *);
 extern void capture_passive_mouse_input(void);
+extern void print_frame_stats(void);
+extern int run_benchmark(unsigned int);
+
+extern double achieved_tps;
 
 /*
  *      COLLISION.C
  */
 extern void apply_collision_v(Vector *, int);
-extern void check_collision(Node *);
+extern void broadphase_move(unsigned int);
+extern void broadphase_remove(unsigned int);
 extern void correct_positions(Vector *, Vector *, double);
-extern void process_deleted_ast(void);
+extern int init_broadphase(void);
+extern void print_collision_stats(void);
+extern void process_collisions(void);
+extern unsigned int process_rock_collisions(void);
+extern unsigned int scan_for_collision_warning(const Vector *);
+extern void set_collision_warning(unsigned int);
+
+extern double flicker_hud_ttl;
+extern int cwg_rear, cwg_above, cwg_below, cwg_left, cwg_right;
 
 /*
  *      DEBUG.C
@@ -63,6 +93,7 @@ extern void draw_debug_grid(void);
  *      DISPLAY.C
  */
 extern void display(void);
+extern void gl_load_view(void);
 
 /*
  *      DUST.C
@@ -80,8 +111,12 @@ extern void init_explosions(void);
 extern void process_explosion(void);
 
 extern Blast explosion[];
-extern int expl_dl[], expl_winshield_particle_dl,
-    expl_winshield_particle_count, explosions_active_flag;
+extern int expl_winshield_particle_count, explosions_active_flag;
+
+/*
+ *      HISCORE.C
+ */
+extern void init_score_display(void);
 
 /*
  *      HUD.C
@@ -92,22 +127,44 @@ extern void draw_text_in_color(double, double, const char *, double, double,
 extern void draw_shield_gauge(void);
 extern void init_hud(void);
 extern void draw_collision_warning_gauge(void);
-extern void scan_for_collision_warning(Asteroid *);
 extern int draw_gauge(void);
 extern void draw_torp_gauge(void);
 
-extern double flicker_hud_ttl;
-extern int cwg_rear, cwg_above, cwg_below, cwg_left, cwg_right;
+/*
+ *      INPUT.C
+ */
+extern void post_input_event(int, int, int, int);
+extern void print_input_stats(void);
+extern void process_input(void);
+
+extern int mouse_rotx_flag, mouse_roty_flag;
+extern double mouse_xprop, mouse_yprop;
+
+/*
+ *      INSTANCE.C
+ */
+extern int draw_instanced_asteroids(const SnapRock *, unsigned int);
+extern void init_instancing(void);
+
+/*
+ *      INTEGRATE.C
+ */
+extern const char *init_integrate(void);
+extern void integrate_wrap(AstVec *, const AstVec *, unsigned int, double,
+    const Vector *);
+extern void integrate_wrap_scalar(AstVec *, const AstVec *, unsigned int,
+    double, const Vector *);
+extern IntegrateFunc integrate_kernel(const char *);
 
 /*
  *      KEYB.C
  */
+extern void apply_key(unsigned char);
 extern void decay_keyb_rotx_scalar(void);
 extern void decay_keyb_roty_scalar(void);
 extern void decay_keyb_rotz_scalar(void);
 extern void keyboard_handler(unsigned char, int, int);
 
-extern KeyboardMap keymap, keymap_old;
 extern int keyb_rotx_scalar, keyb_roty_scalar, keyb_rotz_scalar;
 
 /*
@@ -124,15 +181,24 @@ extern float l0_pos[], l1_pos[], l1_dir[];
  *      MAIN.C
  */
 extern void end_game(void);
+extern void finish_game(void);
 extern void mouse_handler(int, int, int, int);
 extern void passive_mouse_handler(int, int);
+extern void print_startup_times(void);
 
-extern double dt, tps;
-extern int game_end_flag;
-extern int mouse_rotx_flag, mouse_roty_flag, mouse_x, mouse_y;
-extern double mouse_xprop, mouse_yprop;
+extern int mouse_x, mouse_y;
 extern pthread_mutex_t run_yield;
-extern unsigned long ticks;
+
+/*
+ *      MODELS.C
+ */
+extern void gl_ast_material(void);
+extern void init_models(void);
+
+extern RockMesh ast_mesh[];
+extern int ast_dl[], expl_dl[], expl_winshield_particle_dl, shield_dl,
+    torp_dl, torp_billboard_dl;
+extern unsigned int ast_tex[], torp_tex;
 
 /*
  *      MOVE.C
@@ -150,21 +216,35 @@ extern Vector rotation;
  *      OGLUTILS.C
  */
 extern void apply_v2m(Vector *, const double *);
-extern int gen_rand_int(int, int);
-extern void gen_rand_vec(Vector *);
-extern double gen_rand_float(double, double);
 extern void find_rotation_angles(const Vector *, double *, double *);
 extern void find_rotation_mat(double, const Vector *, double *);
 
+/*
+ *      PACE.C
+ */
+extern void init_pacer(void);
+
 /*
  *      PAUSE.C
  */
 extern int paused(void);
 extern void paused_display(void);
 extern void start_pause(void);
+extern void wait_while_paused(void);
 
 extern int paused_flag;
 
+/*
+ *      RANDOM.C
+ */
+extern double gen_rand_float(double, double);
+extern void gen_rand_floats(double *, unsigned int, unsigned int, double,
+    double);
+extern int gen_rand_int(int, int);
+extern void gen_rand_unit_vecs(Vector *, unsigned int);
+extern void rng_seed(unsigned long long);
+extern void rng_select(unsigned int);
+
 /*
  *      RCFILE.C
  */
@@ -173,14 +253,14 @@ extern void read_rcfile(void) ;
 extern char *strip_nl(char *);
 extern void write_rcfile_to_terminal(int);
 
+extern KeyboardMap keymap, keymap_old;
 extern UserOptionsMap optmap;
 extern char *rcfile;
 
 /*
  *      SCORE.C
  */
-extern void add_rock_to_score(const Asteroid *);
-extern void init_score_display(void);
+extern void add_rock_to_score(const Vector *, int);
 
 extern double difficulty_multiplier;
 extern unsigned int score;
@@ -188,12 +268,32 @@ extern unsigned int score;
 /*
  *      SHIELD.C
  */
-extern int shield_dl, shield_ttl, shield_activated_flag;
+extern int shield_ttl, shield_activated_flag;
 extern float shield_strength;
 
 extern void init_shield(void);
 extern void process_shield(void);
 
+/*
+ *      SIM.C
+ */
+extern void run_sim_tick(void);
+
+extern double dt, tps;
+extern int game_end_flag, sim_profile_flag;
+extern const char *const sim_phase_name[];
+extern double sim_phase_time[];
+extern unsigned long ticks;
+
+/*
+ *      SNAPSHOT.C
+ */
+extern const RenderSnapshot *acquire_snapshot(void);
+extern void init_snapshots(void);
+extern void publish_snapshot(double);
+
+extern const RenderSnapshot *snapshot;
+
 /*
  *      SOUND.C
  */
@@ -204,7 +304,9 @@ extern void process_sound(void);
 /*
  *      SPLIT.C
  */
-extern void add_new_asteroids(const Vector *, int);
+extern void print_spawn_stats(void);
+extern void queue_new_asteroids(const Vector *, int);
+extern unsigned int spawn_new_asteroids(void);
 
 /*
  *      SUN.C
@@ -225,17 +327,14 @@ extern void draw_lcs(const Asteroid *);
 extern void draw_steering_cue(const Asteroid *);
 extern void draw_target_box(const Asteroid *);
 extern void draw_target_vector(const Asteroid *);
-extern void drop_target(void);
 extern void init_target_dls(void);
-extern int is_targeted(const Asteroid *);
 extern void target_asteroid(void);
 
-extern Node *currently_targeted_asteroid;
-
 /*
  *      TEXTURE.C
  */
 extern void init_textures(void);
+extern void load_textures(Job *);
 
 extern int nebula_dl[];
 extern unsigned int nebula_tex[];
@@ -253,8 +352,8 @@ extern Vector thrust, velocity;
 /*
  *      TORPEDO.C
  */
-extern void calc_torp_billboard_rot(const Vector *, double *, double *);
-extern void draw_torp_plasma(void);
+extern void calc_torp_billboard_rot(const Vector *, const Vector *, double *,
+    double *);
 extern void fire_torpedo(void);
 extern void init_torpedo(void);
 extern void init_torpedo_trails(void);
@@ -263,17 +362,20 @@ extern void process_torpedo_motion(int);
 extern void process_torpedo_trails(void);
 
 extern Torpedo torp[], sorted_torp[];
-extern int torp_dl, torp_billboard_dl, torps_in_flight_flag, tracer_light_flag;
-extern unsigned int torp_tex;
+extern int torps_in_flight_flag, tracer_light_flag;
 extern TorpedoTrail torp_trail[];
 
 /*
  *      VIEW.C
  */
+extern void eye_matrix(double *, const Vector *, const Vector *,
+    const Vector *, const Vector *);
+extern void orient_axes(const Quat *, Vector *, Vector *, Vector *);
+extern void quat_slerp(Quat *, const Quat *, const Quat *, double);
 extern void reset_view(void);
-extern void rotate_view_aboutx(double);
-extern void rotate_view_abouty(double);
-extern void rotate_view_aboutz(double);
+extern void rotate_view(const Vector *);
+extern void view_matrix(double *);
+extern void view_orient(Quat *);
 
 extern Vector pos, xaxis, yaxis, zaxis;
 
@@ -282,9 +384,21 @@ extern Vector pos, xaxis, yaxis, zaxis;
  */
 extern void gen_rand_wind_part(WindPart *, double);
 extern void init_wind_parts(void);
+extern void process_wind_parts(void);
 
 extern WindPart winshield_particle[];
 
+/*
+ *      WORKERS.C
+ */
+extern Job *create_job(JobFunc, void *, Job *);
+extern unsigned int init_workers(unsigned int);
+extern void print_worker_stats(void);
+extern void run_parallel(WorkFunc, unsigned int);
+extern unsigned int set_active_workers(unsigned int);
+extern void submit_job(Job *);
+extern void wait_job(Job *);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
@@ -0,0 +1,275 @@
+/* Asteroids3D - a first person game of blowing up asteroids
+ * Copyright (C) 2000 Stuart Mark Pomerantz <smp [at] psc edu>
+ * Copyright © Jan Engelhardt <jengelh [at] gmx de>, 2003 - 2006
+ *
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  Stuart Pomerantz
+ *  3935 Stonecliffe drive
+ *  Monroeville, PA 15146
+ */
+
+/*
+ * Random numbers: xoshiro256** generators seeded from one 64-bit seed, so
+that a game can be replayed from its seed. There is one stream per
+subsystem (RNG_SIM, RNG_RENDER) and per worker thread (RNG_WORKER + id).
+Stream k starts k jumps of 2^128 draws after stream 0, so streams never
+overlap. Each thread draws from the stream picked by rng_select(), the main
+thread from RNG_RENDER until it picks another one. A stream must only be
+used by one thread at a time; handing it on across pthread_create() or a
+mutex is fine.
+ *
+ * Random directions come from Marsaglia's method: a point (u, w) drawn
+evenly from the unit disc maps to an evenly spread point on the unit
+sphere with a square root and no trigonometry. Points outside the disc
+(about 21%) are thrown away. The points are drawn in batches and mapped by
+a kernel; the AVX2 one does four at a time and gives the same vectors as
+the scalar one.
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include "asteroids3D.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#	define HAVE_X86_KERNELS 1
+#	include <immintrin.h>
+#endif
+
+/* Most points gen_rand_unit_vecs() draws from the disc at a time */
+#define UNIT_BATCH 64
+
+typedef unsigned int (*UnitVecFunc)(Vector *, const double *, unsigned int,
+    unsigned int);
+
+static inline uint64_t rotl(uint64_t, unsigned int);
+static inline uint64_t next(uint64_t *);
+static inline double next_unit(uint64_t *);
+static void jump(uint64_t *);
+static unsigned int unit_vecs_scalar(Vector *, const double *, unsigned int,
+    unsigned int);
+#ifdef HAVE_X86_KERNELS
+static unsigned int unit_vecs_avx2(Vector *, const double *, unsigned int,
+    unsigned int);
+#endif
+
+static uint64_t rng_state[NUM_RNG_STREAMS][4];
+static __thread uint64_t *rng_current = rng_state[RNG_RENDER];
+
+/* Selected by rng_seed() */
+static UnitVecFunc unit_vecs_impl = unit_vecs_scalar;
+
+//-----------------------------------------------------------------------------
+/* Restart all streams from seed. Must be called before the first draw and
+while no other thread is drawing. */
+void rng_seed(unsigned long long seed)
+{
+	uint64_t z;
+	unsigned int k, i;
+
+	/* splitmix64 spreads the seed over the 256 state bits */
+	for (i = 0; i < 4; ++i) {
+		z  = (seed += 0x9e3779b97f4a7c15ULL);
+		z  = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+		z  = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+		rng_state[0][i] = z ^ (z >> 31);
+	}
+
+	for (k = 1; k < NUM_RNG_STREAMS; ++k) {
+		for (i = 0; i < 4; ++i)
+			rng_state[k][i] = rng_state[k-1][i];
+		jump(rng_state[k]);
+	}
+
+#ifdef HAVE_X86_KERNELS
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		unit_vecs_impl = unit_vecs_avx2;
+#endif
+	return;
+}
+
+/* Let the calling thread draw from the given RNG_* stream */
+void rng_select(unsigned int stream)
+{
+	rng_current = rng_state[stream];
+	return;
+}
+
+/* A uniformly distributed integer in [lo, hi] */
+int gen_rand_int(int lo, int hi)
+{
+	return lo + static_cast(int, next_unit(rng_current) * (hi - lo + 1.0));
+}
+
+/* A uniformly distributed float in [min, max) */
+double gen_rand_float(double min, double max)
+{
+	return min + (max - min) * next_unit(rng_current);
+}
+
+/* Fill v[0], v[stride], ... v[(n-1)*stride] with floats in [min, max), the
+same values as n calls to gen_rand_float() but without the per-call
+overhead. A stride of 4 fills one member of a Vector array. */
+void gen_rand_floats(double *v, unsigned int n, unsigned int stride,
+    double min, double max)
+{
+	uint64_t s[4], *cur = rng_current;
+	double len = max - min;
+	unsigned int i;
+
+	for (i = 0; i < 4; ++i)
+		s[i] = cur[i];
+	for (i = 0; i < n; ++i, v += stride)
+		*v = min + len * next_unit(s);
+	for (i = 0; i < 4; ++i)
+		cur[i] = s[i];
+	return;
+}
+
+/* Fill v[0..n-1] with directions spread evenly over the unit sphere */
+void gen_rand_unit_vecs(Vector *v, unsigned int n)
+{
+	double uw[2 * UNIT_BATCH];
+	unsigned int pairs, k;
+
+	while (n > 0) {
+		/* enough points that all n usually land in the disc */
+		pairs = n + n / 4 + 1;
+		if (pairs > UNIT_BATCH)
+			pairs = UNIT_BATCH;
+		gen_rand_floats(uw, 2 * pairs, 1, -1, 1);
+		k  = unit_vecs_impl(v, uw, pairs, n);
+		v += k;
+		n -= k;
+	}
+	return;
+}
+
+/* Map the points (uw[2*i], uw[2*i+1]) inside the unit disc to unit vectors
+in v, stopping after max of them. Returns how many were stored. */
+static unsigned int unit_vecs_scalar(Vector *v, const double *uw,
+    unsigned int pairs, unsigned int max)
+{
+	double u, w, s, r;
+	unsigned int i, k = 0;
+
+	for (i = 0; i < pairs && k < max; ++i) {
+		u = uw[2*i];
+		w = uw[2*i+1];
+		s = u * u + w * w;
+		if (!(s < 1))
+			continue;
+		r = 2 * sqrt(1 - s);
+		v[k].x = u * r;
+		v[k].y = w * r;
+		v[k].z = 1 - 2 * s;
+		v[k].w = 0;
+		++k;
+	}
+	return k;
+}
+
+#ifdef HAVE_X86_KERNELS
+__attribute__((target("avx2")))
+static unsigned int unit_vecs_avx2(Vector *v, const double *uw,
+    unsigned int pairs, unsigned int max)
+{
+	const __m256d one = _mm256_set1_pd(1), two = _mm256_set1_pd(2);
+	__m256d a, b, u, w, s, r;
+	double x[4], y[4], z[4];
+	unsigned int i = 0, j, k = 0, in;
+
+	for (; i + 4 <= pairs && k < max; i += 4, uw += 8) {
+		/* u0 w0 u1 w1 | u2 w2 u3 w3 -> u0 u1 u2 u3 and w0 w1 w2 w3 */
+		a = _mm256_loadu_pd(uw);
+		b = _mm256_loadu_pd(uw + 4);
+		u = _mm256_permute4x64_pd(_mm256_unpacklo_pd(a, b), 0xd8);
+		w = _mm256_permute4x64_pd(_mm256_unpackhi_pd(a, b), 0xd8);
+
+		s  = _mm256_add_pd(_mm256_mul_pd(u, u), _mm256_mul_pd(w, w));
+		in = _mm256_movemask_pd(_mm256_cmp_pd(s, one, _CMP_LT_OQ));
+		if (in == 0)
+			continue;
+		r = _mm256_mul_pd(two, _mm256_sqrt_pd(_mm256_sub_pd(one, s)));
+		_mm256_storeu_pd(x, _mm256_mul_pd(u, r));
+		_mm256_storeu_pd(y, _mm256_mul_pd(w, r));
+		_mm256_storeu_pd(z, _mm256_sub_pd(one, _mm256_mul_pd(two, s)));
+
+		for (j = 0; j < 4 && k < max; ++j)
+			if (in & (1 << j)) {
+				v[k].x = x[j];
+				v[k].y = y[j];
+				v[k].z = z[j];
+				v[k].w = 0;
+				++k;
+			}
+	}
+
+	_mm256_zeroupper();
+	if (k < max)
+		k += unit_vecs_scalar(v + k, uw, pairs - i, max - k);
+	return k;
+}
+#endif // HAVE_X86_KERNELS
+
+static inline uint64_t rotl(uint64_t x, unsigned int k)
+{
+	return (x << k) | (x >> (64 - k));
+}
+
+/* xoshiro256** by David Blackman and Sebastiano Vigna (public domain) */
+static inline uint64_t next(uint64_t *s)
+{
+	uint64_t result = rotl(s[1] * 5, 7) * 9, t = s[1] << 17;
+
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+	s[2] ^= t;
+	s[3] = rotl(s[3], 45);
+	return result;
+}
+
+/* The top 53 bits of a draw as a double in [0, 1) */
+static inline double next_unit(uint64_t *s)
+{
+	return (next(s) >> 11) * (1.0 / (UINT64_C(1) << 53));
+}
+
+/* Advance s by 2^128 draws */
+static void jump(uint64_t *s)
+{
+	static const uint64_t poly[] = {
+		0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL,
+		0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL,
+	};
+	uint64_t t[4] = {0, 0, 0, 0};
+	unsigned int i, b, k;
+
+	for (i = 0; i < 4; ++i)
+		for (b = 0; b < 64; ++b) {
+			if (poly[i] & (UINT64_C(1) << b))
+				for (k = 0; k < 4; ++k)
+					t[k] ^= s[k];
+			next(s);
+		}
+
+	for (k = 0; k < 4; ++k)
+		s[k] = t[k];
+	return;
+}
@@ -45,20 +45,97 @@ UserOptionsMap optmap = {
 	.draw_shield_flag         = 1,
 	.draw_torp_lensflare_flag = 1, // was 0
 	.draw_tracer_flag         = 1,
+	.instancing_flag          = 1,
+	.interpolate_flag         = 1,
 	.mouse_xdir               = 1, // 1 or -1
 	.mouse_ydir               = 1,
 	.nebula_texture_flag      = 0,
 	.num_asteroids            = NUM_ASTEROIDS,
+	.max_asteroids            = 0,
+	.max_fps                  = 0,
 	.play_sound_flag          = 1,
+	.rock_collision_flag      = 1,
+	.sim_lod_flag             = 1,
 	.target_box_type          = 0,
 	.texture_flag             = 1,
 	.torp_texture_flag        = 1,
+	.vsync_flag               = 1,
 	.windowx                  = 800, // window size in pixels
 	.window_xpos              = 0,   // window position offset (was 150,50)
 	.windowy                  = 600,
 	.window_ypos              = 0,
 };
 
+// Define the keyboard map
+KeyboardMap keymap = {
+	.asteroid_texture_toggle    = 'm',
+	.auto_target_asteroid       = 'b', // was '\t'
+	.axes_toggle                = '$',
+	.crosshair_toggle           = '+',
+	.draw_dust_toggle           = '(',
+	.draw_shield_toggle         = ')',
+	.draw_torp_lensflare_toggle = '*',
+	.draw_tracer_toggle         = '_',
+	.end_game                   = 27 /* == '\e' */,
+	.fire_torp                  = ' ',
+	.headlight_toggle           = '[',
+	.nebula_texture_toggle      = 'k',
+	.pause                      = 'p',
+	.play_sound_toggle          = '#',
+	.reverse_mouse_x_toggle     = '!',
+	.reverse_mouse_y_toggle     = '@',
+	.rock_collision_toggle      = 'j',
+	.rot_aboutx_ccw             = '2',
+	.rot_aboutx_cw              = '8',
+	.rot_abouty_ccw             = '4',
+	.rot_abouty_cw              = '6',
+	.rot_aboutz_ccw             = 'e',
+	.rot_aboutz_cw              = 'q',
+	.slide_backward             = 'w', // was 'v'
+	.slide_down                 = 'x', // was 't'
+	.slide_forward              = 's', // was 'r'
+	.slide_left                 = 'a', // was 'd'
+	.slide_right                = 'd', // was 'g'
+	.slide_up                   = 'c',
+	.stop                       = 'f',
+	.target_asteroid            = '\t', // was 'b'
+	.torp_texture_toggle        = 'o',
+};
+KeyboardMap keymap_old = {
+	.asteroid_texture_toggle    = '&',
+	.auto_target_asteroid       = '\t',
+	.axes_toggle                = '$',
+	.crosshair_toggle           = '+',
+	.draw_dust_toggle           = '(',
+	.draw_shield_toggle         = ')',
+	.draw_torp_lensflare_toggle = '*',
+	.draw_tracer_toggle         = '_',
+	.end_game                   = 27 /* == '\e' */,
+	.fire_torp                  = ' ',
+	.headlight_toggle           = '[',
+	.nebula_texture_toggle      = '^',
+	.pause                      = 'p',
+	.play_sound_toggle          = '#',
+	.reverse_mouse_x_toggle     = '!',
+	.reverse_mouse_y_toggle     = '@',
+	.rock_collision_toggle      = 'j',
+	.rot_aboutx_ccw             = '2',
+	.rot_aboutx_cw              = '8',
+	.rot_abouty_ccw             = '4',
+	.rot_abouty_cw              = '6',
+	.rot_aboutz_ccw             = '9',
+	.rot_aboutz_cw              = '7',
+	.slide_backward             = 'v',
+	.slide_down                 = 't',
+	.slide_forward              = 'r',
+	.slide_left                 = 'd',
+	.slide_right                = 'g',
+	.slide_up                   = 'c',
+	.stop                       = 'f',
+	.target_asteroid            = 'b',
+	.torp_texture_toggle        = '%',
+};
+
 char *rcfile = NULL; // the full pathname of the rcfile
 
 //-----------------------------------------------------------------------------
@@ -137,6 +214,7 @@ void read_rcfile(void)
 		TOK_K("play_sound_toggle_key", keymap.play_sound_toggle);
 		TOK_K("reverse_mouse_x_toggle_key", keymap.reverse_mouse_x_toggle);
 		TOK_K("reverse_mouse_y_toggle_key", keymap.reverse_mouse_y_toggle);
+		TOK_K("rock_collision_toggle_key", keymap.rock_collision_toggle);
 		TOK_K("rot_aboutx_ccw_key", keymap.rot_aboutx_ccw);
 		TOK_K("rot_aboutx_cw_key", keymap.rot_aboutx_cw);
 		TOK_K("rot_abouty_ccw_key", keymap.rot_abouty_ccw);
@@ -158,16 +236,23 @@ void read_rcfile(void)
 		TOK_F("crosshair", optmap.crosshair_flag);
 		TOK_F("debugging_axes", optmap.axes_flag);
 		TOK_F("dust_effect", optmap.draw_dust_flag);
+		TOK_F("instanced_asteroids", optmap.instancing_flag);
+		TOK_F("interpolate", optmap.interpolate_flag);
 		TOK_F("nebula_textures", optmap.nebula_texture_flag);
+		TOK_F("rock_collisions", optmap.rock_collision_flag);
 		TOK_F("shield_effect", optmap.draw_shield_flag);
+		TOK_F("sim_lod", optmap.sim_lod_flag);
 		TOK_F("sound", optmap.play_sound_flag);
 		TOK_F("torp_lensflares", optmap.draw_torp_lensflare_flag);
 		TOK_F("torp_textures", optmap.torp_texture_flag);
 		TOK_F("torp_tracer_effect", optmap.draw_tracer_flag);
+		TOK_F("vsync", optmap.vsync_flag);
 
 		TOK_M("reverse_mouse_x", optmap.mouse_xdir);
 		TOK_M("reverse_mouse_y", optmap.mouse_ydir);
 
+		TOK_N("max_asteroids", optmap.max_asteroids, 0);
+		TOK_N("max_fps", optmap.max_fps, 0);
 		TOK_N("num_asteroids", optmap.num_asteroids, 2);
 		TOK_N("target_box_type", optmap.target_box_type, 0);
 		TOK_N("win_height", optmap.windowy, 0);
@@ -270,6 +355,7 @@ void write_rcfile_to_terminal(int oldmap)
 	TOK_K("play_sound_toggle_key", kmap->play_sound_toggle, "key to toggle the sound on and off");
 	TOK_K("reverse_mouse_x_toggle_key", kmap->reverse_mouse_x_toggle, "key to toggle the x-axis mouse reverse on and off");
 	TOK_K("reverse_mouse_y_toggle_key", kmap->reverse_mouse_y_toggle, "key to toggle the y-axis mouse reverse on and off");
+	TOK_K("rock_collision_toggle_key", kmap->rock_collision_toggle, "key to toggle asteroid-asteroid collisions on and off");
 	TOK_K("rot_aboutx_ccw_key", kmap->rot_aboutx_cw, "rotate counter-clockwise about x-axis");
 	TOK_K("rot_aboutx_cw_key", kmap->rot_aboutx_cw, "rotate clockwise about x-axis");
 	TOK_K("rot_abouty_ccw_key", kmap->rot_aboutx_cw, "rotate counter-clockwise about y-axis");
@@ -291,16 +377,23 @@ void write_rcfile_to_terminal(int oldmap)
 	TOK_F("crosshair", optmap.crosshair_flag, "crosshair");
 	TOK_F("debugging_axes", optmap.axes_flag, "my debugging axes");
 	TOK_F("dust_effect", optmap.draw_dust_flag, "dust effect");
+	TOK_F("instanced_asteroids", optmap.instancing_flag, "draw the asteroids of a kind in one call, where GL can");
+	TOK_F("interpolate", optmap.interpolate_flag, "blend frames between ticks of the game");
 	TOK_F("nebula_textures", optmap.nebula_texture_flag, "display textured nebula billboards");
+	TOK_F("rock_collisions", optmap.rock_collision_flag, "asteroids bounce off each other");
 	TOK_F("shield_effect", optmap.draw_shield_flag, "shield effect");
+	TOK_F("sim_lod", optmap.sim_lod_flag, "update far asteroids less often");
 	TOK_F("sound", optmap.play_sound_flag, "sounds");
 	TOK_F("torp_lensflares", optmap.draw_torp_lensflare_flag, "torp lens flare");
 	TOK_F("torp_textures", optmap.torp_texture_flag, "texture map the torps");
 	TOK_F("torp_tracer_effect", optmap.draw_tracer_flag, "torpedo tracer light effect");
+	TOK_F("vsync", optmap.vsync_flag, "wait for the vertical retrace to show a frame");
 
 	TOK_M("reverse_mouse_x", optmap.mouse_xdir, "reverse mouse x direction");
 	TOK_M("reverse_mouse_y", optmap.mouse_ydir, "reverse mouse y direction");
 
+	TOK_N("max_asteroids", optmap.max_asteroids, "most asteroids alive at once, 0 = four times num_asteroids");
+	TOK_N("max_fps", optmap.max_fps, "most frames drawn per second, 0 = no limit");
 	TOK_N("num_asteroids", optmap.num_asteroids, "starting number of asteroids in the game");
 	TOK_N("win_height", optmap.windowy, "window height");
 	TOK_N("win_width", optmap.windowx, "window width");
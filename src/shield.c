@@ -22,47 +22,17 @@
  *  Monroeville, PA 15146
  */
 
-#include <GL/glut.h>
 #include "asteroids3D.h"
 
-// Shield display list, shield ttl, and shield strength
-int shield_dl, shield_ttl, shield_activated_flag = 0;
+// Shield ttl and shield strength
+int shield_ttl, shield_activated_flag = 0;
 float shield_strength;
 
 //-----------------------------------------------------------------------------
-void init_shield(void) {
-	static const float emit0[]    = {0.0, 0.6, 0.0, 1.0};
-	static const float ad0[]      = {0.0, 0.0, 0.0, 0.5};
-	static const float emit_off[] = {0.0, 0.0, 0.0, 1.0};
-	static const float width = 2.0, height = 2.0; /* width and height should be chosen to cover window */
-
-	/* set the initial shield strength */
-
-	shield_strength = MAX_SHIELD ;
-
-	/* initialize the shield display list */
-
-	shield_dl = glGenLists (1);
-	glNewList (shield_dl, GL_COMPILE);
-		glEnable(GL_BLEND) ;
-		glBlendFunc(GL_SRC_ALPHA,GL_ONE_MINUS_SRC_ALPHA) ;
-		glMaterialfv(GL_FRONT,GL_EMISSION,emit0) ;
-		glMaterialfv(GL_FRONT,GL_AMBIENT_AND_DIFFUSE,ad0) ;
-		glPushMatrix() ;
-			glLoadIdentity() ;
-			glTranslatef(0, 0, -2) ;
-			glBegin( GL_QUADS ) ;
-				glVertex3f(  width , height, 0.0 ) ;
-				glVertex3f( -width , height , 0.0 ) ;
-				glVertex3f( -width , -height , 0.0 ) ;
-				glVertex3f( width ,  -height , 0.0 ) ;
-			glEnd() ;
-		glPopMatrix() ;
-		glMaterialfv(GL_FRONT,GL_EMISSION,emit_off) ;
-		glDisable(GL_BLEND) ;
-	glEndList ();
-
-	return ;
+void init_shield(void)
+{
+	shield_strength = MAX_SHIELD;
+	return;
 }
 
 void process_shield(void) {
@@ -74,5 +44,9 @@ void process_shield(void) {
 		shield_strength += SHIELD_REGEN_PS * dt;
 	if (shield_strength > MAX_SHIELD)
 		shield_strength = MAX_SHIELD;
+
+	/* the shield effect is over */
+	if (shield_activated_flag && ticks > shield_ttl)
+		shield_activated_flag = 0;
 	return;
 }
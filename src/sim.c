@@ -0,0 +1,107 @@
+/* Asteroids3D - a first person game of blowing up asteroids
+ * Copyright (C) 2000 Stuart Mark Pomerantz <smp [at] psc edu>
+ * Copyright © Jan Engelhardt <jengelh [at] gmx de>, 2003 - 2006
+ *
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  Stuart Pomerantz
+ *  3935 Stonecliffe drive
+ *  Monroeville, PA 15146
+ */
+
+/*
+ * The simulation core: one tick of the ship, the asteroid field, torpedos,
+explosions and the shield, with no input, sound or rendering. calc_frame.c
+runs it for the game and sim_main.c runs it without a display.
+ */
+
+#include <time.h>
+#include "asteroids3D.h"
+
+static void end_phase(unsigned int, struct timespec *);
+
+/* The code which generates data for rendering will cycle some number of ticks
+per second.
+On a "slow" computer, this code will go slower than the number of ticks per
+second. The limiting factor should always be the time to render, however.
+On a "fast" computer, this code will cycle no faster than ticks per second, so
+the game should never be un-playable on a "fast" computer. */
+#define TPS 60.0
+
+int game_end_flag = 0; /* is the game over */
+
+/* the number of game time ticks that have past */
+unsigned long ticks = 0;
+
+/* dt = delta time, the amount of time (in seconds)
+ *  which passes with each game tick
+ */
+double dt = 1.0 / TPS;
+
+/* this is the number of ticks per second, which I may want to change dynamically */
+double tps = TPS;
+
+/* When sim_profile_flag is set, the seconds spent in each SIM_* phase of
+run_sim_tick() are added up in sim_phase_time[]. */
+int sim_profile_flag = 0;
+double sim_phase_time[NUM_SIM_PHASES];
+const char *const sim_phase_name[NUM_SIM_PHASES] = {
+	"ship", "asteroids", "deletion", "rock collisions", "torpedos",
+	"explosions", "shield",
+};
+
+//-----------------------------------------------------------------------------
+void run_sim_tick(void)
+{
+	struct timespec t;
+
+	if (sim_profile_flag)
+		clock_gettime(CLOCK_MONOTONIC, &t);
+
+	apply_thrust(1); /* keyboard & mouse motion */
+	process_motion(1); /* ship motion */
+	end_phase(SIM_SHIP, &t);
+	process_asteroid_motion(1);	/* ...and asteroid motion. Comment this out to browse the data set */
+	end_phase(SIM_ASTEROIDS, &t);
+	process_deleted_ast();
+	end_phase(SIM_DELETION, &t);
+	if (optmap.rock_collision_flag)
+		process_rock_collisions();
+	end_phase(SIM_ROCK_COLLISIONS, &t);
+	process_torpedo_motion(1);
+	process_torpedo_trails();
+	end_phase(SIM_TORPEDOS, &t);
+	process_explosion();
+	end_phase(SIM_EXPLOSIONS, &t);
+	process_shield();
+	end_phase(SIM_SHIELD, &t);
+	++ticks;
+	return;
+}
+
+/* Charge the time since *t to the given phase and restart *t */
+static void end_phase(unsigned int phase, struct timespec *t)
+{
+	struct timespec now;
+
+	if (!sim_profile_flag)
+		return;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	sim_phase_time[phase] += (now.tv_sec - t->tv_sec) +
+	                         (now.tv_nsec - t->tv_nsec) / 1e9;
+	*t = now;
+	return;
+}
@@ -0,0 +1,200 @@
+/* Asteroids3D - a first person game of blowing up asteroids
+ * Copyright (C) 2000 Stuart Mark Pomerantz <smp [at] psc edu>
+ * Copyright © Jan Engelhardt <jengelh [at] gmx de>, 2003 - 2006
+ *
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  Stuart Pomerantz
+ *  3935 Stonecliffe drive
+ *  Monroeville, PA 15146
+ */
+
+/*
+ * asteroids3D-sim: the simulation core without GL, for timing it on machines
+without a display. A scripted player sits still, slowly yaws and fires a
+torpedo every SIM_FIRE_PERIOD seconds, and the ticks are run back to back.
+The ticks per second and the time spent in each phase of run_sim_tick() are
+printed at the end. The same seed always gives the same game.
+ *
+ * usage: asteroids3D-sim [-num n] [-ticks n] [-seed n] [-tps n] [-threads n]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "asteroids3D.h"
+
+#define SIM_FIRE_PERIOD 0.25 // seconds between shots of the scripted player
+#define SIM_YAW_DPS     20   // degrees per second it turns
+
+static void parse_command_line(int, char **);
+static void print_phase_times(double);
+
+static unsigned int sim_ticks = 1000;
+static unsigned long long sim_seed = 1;
+static unsigned long ship_losses = 0;
+static unsigned int sim_threads = 0;
+
+//-----------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+	struct timespec t0, t1;
+	unsigned int i, fire_ticks;
+	double elapsed;
+
+	parse_command_line(argc, argv);
+	rng_seed(sim_seed);
+	rng_select(RNG_SIM);
+	init_workers(sim_threads);
+	reset_view();
+	init_thrust();
+	init_torps();
+	init_asteroids();
+	init_shield();
+	init_explosions();
+
+	printf("%d asteroids, %u ticks at %.0f tps, seed %llu, "
+	       "%u worker thread(s)\n", optmap.num_asteroids, sim_ticks, tps,
+	       sim_seed, set_active_workers(0));
+
+	fire_ticks = SIM_FIRE_PERIOD * tps;
+	if (fire_ticks == 0)
+		fire_ticks = 1;
+	sim_profile_flag = 1;
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (i = 0; i < sim_ticks; ++i) {
+		turn_abouty(SIM_YAW_DPS);
+		if (i % fire_ticks == 0)
+			fire_torpedo();
+		run_sim_tick();
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	elapsed = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+
+	printf("%u ticks in %.3f s: %.1f ticks/s (%.1fx real time)\n",
+	       sim_ticks, elapsed, sim_ticks / elapsed,
+	       sim_ticks / elapsed / tps);
+	print_phase_times(elapsed);
+	printf("%u asteroids left, score %u, ship destroyed %lu time(s)\n",
+	       afield.count, score, ship_losses);
+	print_asteroid_pool_stats();
+	print_spawn_stats();
+	print_lod_stats();
+	print_collision_stats();
+	print_worker_stats();
+	return EXIT_SUCCESS;
+}
+
+/* The game calls this once the shield is gone. Here the ship gets a fresh
+shield instead, so that every run does the same number of ticks. */
+void end_game(void)
+{
+	++ship_losses;
+	shield_strength = MAX_SHIELD;
+	return;
+}
+
+static void print_phase_times(double elapsed)
+{
+	unsigned int p;
+
+	for (p = 0; p < NUM_SIM_PHASES; ++p)
+		printf("  %-16s %9.3f us/tick  %5.1f%%\n", sim_phase_name[p],
+		       sim_phase_time[p] * 1e6 / sim_ticks,
+		       100 * sim_phase_time[p] / elapsed);
+	return;
+}
+
+static void parse_command_line(int argc, char **argv)
+{
+	unsigned long long temp3;
+	int i, temp1;
+	double temp2;
+
+	for (i = 1; i < argc; ++i) {
+		if (strcmp("-help", argv[i]) == 0 ||
+		    strcmp("-h", argv[i]) == 0 ||
+		    strcmp("--help", argv[i]) == 0 ||
+		    strcmp("-?", argv[i]) == 0)
+		{
+			printf("valid command line options:\n");
+			printf("   -num <number>\n"
+			       "         to set the number of asteroids (default: %d)\n\n",
+			       NUM_ASTEROIDS);
+			printf("   -ticks <number>\n"
+			       "         to set the number of ticks to run (default: 1000)\n\n");
+			printf("   -seed <number>\n"
+			       "         to set the random seed (default: 1)\n\n");
+			printf("   -tps <number>\n"
+			       "         to set the ticks per second of game time (default: %.0f)\n\n",
+			       tps);
+			printf("   -threads <number>\n"
+			       "         to run the job system on <number> threads (default: one per CPU)\n\n");
+			printf("   -nolod\n"
+			       "         to move every asteroid every tick\n\n");
+			exit(EXIT_SUCCESS);
+		} else if (strcmp("-num", argv[i]) == 0) {
+			if (i + 1 < argc) {
+				if (sscanf(argv[i+1], "%d\n", &temp1) == 1) {
+					if (temp1 > 1)
+						optmap.num_asteroids = temp1;
+					++i;
+				}
+			}
+		} else if (strcmp("-ticks", argv[i]) == 0) {
+			if (i + 1 < argc) {
+				if (sscanf(argv[i+1], "%d\n", &temp1) == 1) {
+					if (temp1 > 0)
+						sim_ticks = temp1;
+					++i;
+				}
+			}
+		} else if (strcmp("-seed", argv[i]) == 0) {
+			if (i + 1 < argc) {
+				if (sscanf(argv[i+1], "%llu\n", &temp3) == 1) {
+					sim_seed = temp3;
+					++i;
+				}
+			}
+		} else if (strcmp("-tps", argv[i]) == 0) {
+			if (i + 1 < argc) {
+				if (sscanf(argv[i+1], "%lf\n", &temp2) == 1) {
+					if (temp2 > 0) {
+						tps = temp2;
+						dt  = 1 / tps;
+					}
+					++i;
+				}
+			}
+		} else if (strcmp("-threads", argv[i]) == 0) {
+			if (i + 1 < argc) {
+				if (sscanf(argv[i+1], "%d\n", &temp1) == 1) {
+					if (temp1 > 0)
+						sim_threads = temp1;
+					++i;
+				}
+			}
+		} else if (strcmp("-nolod", argv[i]) == 0) {
+			optmap.sim_lod_flag = 0;
+		} else {
+			fprintf(stderr, "Unknown option %s, try -help\n",
+			        argv[i]);
+			exit(EXIT_FAILURE);
+		}
+	}
+	return;
+}
@@ -0,0 +1,360 @@
+/* Asteroids3D - a first person game of blowing up asteroids
+ * Copyright (C) 2000 Stuart Mark Pomerantz <smp [at] psc edu>
+ * Copyright © Jan Engelhardt <jengelh [at] gmx de>, 2003 - 2006
+ *
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  Stuart Pomerantz
+ *  3935 Stonecliffe drive
+ *  Monroeville, PA 15146
+ */
+
+/*
+ * Render snapshots. At the end of every tick the sim thread copies what
+display() needs into a RenderSnapshot and publishes it; the renderer draws
+from the newest ones and never looks at the live sim state, so neither
+thread waits for the other.
+ *
+ * Four snapshots go round: the sim fills its back buffer, the renderer
+holds the two it picked up last, and the fourth is the one last published.
+Publishing swaps the back buffer with the published one. When that is newer
+than what the renderer has, the renderer takes it and gives back the older
+of its two. Each swap is a single atomic exchange of an index, with
+SNAP_FRESH set while the published snapshot has not been picked up.
+ *
+ * The renderer draws a blend of its two snapshots: the eye, the rocks, the
+torps and the explosions are put where they were at the time between the
+two that the current frame falls at, one tick behind the sim. Motion is
+then smooth at any frame rate, however far below it the tick rate is.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "asteroids3D.h"
+#include "vecops.h"
+
+#define SNAP_INDEX 3
+#define SNAP_FRESH 4
+
+/* A rock that moved further than this along an axis between two snapshots
+went around the field, and is not blended */
+#define SNAP_MAX_STEP ABOUND
+
+static void *alloc_or_die(size_t);
+static float blend_angle(float, float, double);
+static void blend_point(float *, const float *, const float *, double);
+static void blend_snapshots(double);
+static void cull_rocks(unsigned int, unsigned int, unsigned int);
+static void match_rocks(void);
+
+static RenderSnapshot snap[4];
+static unsigned int snap_back = 0;  // owned by the sim thread
+static unsigned int snap_ready = 1; // the last one published
+static unsigned int snap_prev = 2;  // owned by the renderer, the older one
+static unsigned int snap_front = 3; // owned by the renderer, the newer one
+
+/* Renderer side: the blend that is drawn, and for each rock of snap_front
+its index in snap_prev or -1. id_rock maps ids to indices in snap_prev. */
+static RenderSnapshot blend;
+static int *prev_rock;
+static unsigned int *id_rock;
+
+/* Sim side: the snapshot being filled, and where each chunk of
+cull_rocks() started putting rocks into it and how many */
+static RenderSnapshot *cull_snap;
+static unsigned int cull_first[MAX_WORKERS], cull_count[MAX_WORKERS];
+
+/* The snapshot being drawn, set by display() */
+const RenderSnapshot *snapshot = &blend;
+
+//-----------------------------------------------------------------------------
+/* Make room for the asteroids. Must be called after init_asteroids(). */
+void init_snapshots(void)
+{
+	unsigned int k;
+
+	for (k = 0; k < 4; ++k)
+		snap[k].rock = alloc_or_die(afield.capacity * sizeof(SnapRock));
+	blend.rock = alloc_or_die(afield.capacity * sizeof(SnapRock));
+	prev_rock  = alloc_or_die(afield.capacity * sizeof(int));
+	id_rock    = alloc_or_die(afield.capacity * sizeof(unsigned int));
+	return;
+}
+
+static void *alloc_or_die(size_t size)
+{
+	void *p = calloc(1, size);
+
+	if (p == NULL) {
+		perror("calloc");
+		exit(EXIT_FAILURE);
+	}
+	return p;
+}
+
+/* Copy the state the renderer needs and hand it over. Called by the sim
+thread after each tick, and once before it is started; stamp is when the
+tick was due, in seconds of the monotonic clock. */
+void publish_snapshot(double stamp)
+{
+	RenderSnapshot *s = &snap[snap_back];
+	unsigned int c, n = 0;
+	int k;
+
+	s->ticks = ticks;
+	s->stamp = stamp;
+	view_matrix(s->view);
+	view_orient(&s->orient);
+	s->pos      = pos;
+	s->xaxis    = xaxis;
+	s->yaxis    = yaxis;
+	s->zaxis    = zaxis;
+	s->velocity = velocity;
+
+	/* Each chunk culls into its own part of the array, which is then
+	closed up, so the rocks keep their order */
+	cull_snap = s;
+	memset(cull_count, 0, sizeof(cull_count));
+	run_parallel(cull_rocks, afield.count);
+	for (c = 0; c < MAX_WORKERS; ++c) {
+		if (cull_count[c] == 0)
+			continue;
+		memmove(&s->rock[n], &s->rock[cull_first[c]],
+		        cull_count[c] * sizeof(SnapRock));
+		n += cull_count[c];
+	}
+	s->num_rocks = n;
+
+	if ((k = ast_resolve(current_target)) >= 0)
+		ast_load(k, &s->target);
+	s->have_target = k >= 0;
+	s->current_target = current_target;
+
+	memcpy(s->torp, torp, sizeof(s->torp));
+	memcpy(s->sorted_torp, sorted_torp, sizeof(s->sorted_torp));
+	memcpy(s->torp_trail, torp_trail, sizeof(s->torp_trail));
+	memcpy(s->explosion, explosion, sizeof(s->explosion));
+	memcpy(s->winshield_particle, winshield_particle,
+	       sizeof(s->winshield_particle));
+	memcpy(s->dust_part, dust_part, sizeof(s->dust_part));
+	s->torps_in_flight_flag = torps_in_flight_flag;
+	s->tracer_light_flag = tracer_light_flag;
+	s->explosions_active_flag = explosions_active_flag;
+	s->expl_winshield_particle_count = expl_winshield_particle_count;
+	s->shield_activated_flag = shield_activated_flag;
+	s->draw_shield_flag = optmap.draw_shield_flag;
+	s->shield_strength = shield_strength;
+	s->cwg_rear = cwg_rear;
+	s->cwg_above = cwg_above;
+	s->cwg_below = cwg_below;
+	s->cwg_left = cwg_left;
+	s->cwg_right = cwg_right;
+	s->flicker_hud_ttl = flicker_hud_ttl;
+	s->score = score;
+	s->num_asteroids_on_scanner = num_asteroids_on_scanner;
+	s->achieved_tps = achieved_tps;
+
+	/* the release orders the copies above before the hand-over */
+	snap_back = __atomic_exchange_n(&snap_ready, snap_back | SNAP_FRESH,
+	            __ATOMIC_ACQ_REL) & SNAP_INDEX;
+	return;
+}
+
+/* Put the rocks [first, last) that are in front of the eye into cull_snap,
+from index first on. Only they get drawn. */
+static void cull_rocks(unsigned int chunk, unsigned int first,
+    unsigned int last)
+{
+	SnapRock *rock = &cull_snap->rock[first];
+	Vector p, r, d;
+	unsigned int i;
+	Handle h;
+
+	for (i = first; i < last; ++i) {
+		ast_pos(&p, i);
+		vec_sub(&d, &p, &pos);
+		if (vec_dot(&d, &zaxis) < 0)
+			continue;
+		ast_axis(&r, i);
+		ast_handle(&h, i);
+		rock->pos[0]      = p.x;
+		rock->pos[1]      = p.y;
+		rock->pos[2]      = p.z;
+		rock->rot_axis[0] = r.x;
+		rock->rot_axis[1] = r.y;
+		rock->rot_axis[2] = r.z;
+		rock->rot         = afield.rot[i];
+		rock->type        = afield.type[i];
+		rock->id          = h.index;
+		rock->generation  = h.generation;
+		++rock;
+	}
+	cull_first[chunk] = first;
+	cull_count[chunk] = rock - &cull_snap->rock[first];
+	return;
+}
+
+/* What to draw now: the last two snapshots published, blended for the
+current time. It stays put until the next call. */
+const RenderSnapshot *acquire_snapshot(void)
+{
+	const RenderSnapshot *p, *c;
+	struct timespec now;
+	unsigned int older;
+	double a;
+
+	if (__atomic_load_n(&snap_ready, __ATOMIC_RELAXED) & SNAP_FRESH) {
+		older      = snap_prev;
+		snap_prev  = snap_front;
+		snap_front = __atomic_exchange_n(&snap_ready, older,
+		             __ATOMIC_ACQ_REL) & SNAP_INDEX;
+		match_rocks();
+	}
+
+	/* a is how far the frame is from the older to the newer snapshot;
+	the newer one is drawn as it is one tick after it was due */
+	p = &snap[snap_prev];
+	c = &snap[snap_front];
+	a = 1;
+	if (optmap.interpolate_flag && c->ticks != p->ticks) {
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		a = (now.tv_sec + now.tv_nsec / 1e9 - c->stamp) /
+		    (c->stamp - p->stamp);
+		if (a < 0)
+			a = 0;
+		else if (a > 1)
+			a = 1;
+	}
+	blend_snapshots(a);
+	return &blend;
+}
+
+/* Pair up the rocks of the two snapshots the renderer holds */
+static void match_rocks(void)
+{
+	const RenderSnapshot *p = &snap[snap_prev], *c = &snap[snap_front];
+	const SnapRock *r;
+	unsigned int i, j;
+
+	for (j = 0; j < p->num_rocks; ++j)
+		id_rock[p->rock[j].id] = j;
+	for (i = 0; i < c->num_rocks; ++i) {
+		r = &c->rock[i];
+		j = id_rock[r->id];
+		if (j < p->num_rocks && p->rock[j].id == r->id &&
+		    p->rock[j].generation == r->generation)
+			prev_rock[i] = j;
+		else
+			prev_rock[i] = -1;
+	}
+	return;
+}
+
+/* Fill in blend with the state fraction a of the way from snap_prev to
+snap_front. Whatever cannot be blended is taken from snap_front. */
+static void blend_snapshots(double a)
+{
+	const RenderSnapshot *p = &snap[snap_prev], *c = &snap[snap_front];
+	SnapRock *rock = blend.rock;
+	const Blast *e0;
+	Torpedo *t;
+	Blast *e;
+	Vector d;
+	unsigned int i;
+	double f;
+
+	blend      = *c;
+	blend.rock = rock;
+	memcpy(rock, c->rock, c->num_rocks * sizeof(SnapRock));
+	if (a >= 1)
+		return;
+
+	vec_sub(&d, &c->pos, &p->pos);
+	vec_addmul(&blend.pos, &p->pos, a, &d);
+	quat_slerp(&blend.orient, &p->orient, &c->orient, a);
+	orient_axes(&blend.orient, &blend.xaxis, &blend.yaxis, &blend.zaxis);
+	eye_matrix(blend.view, &blend.pos, &blend.xaxis, &blend.yaxis,
+	           &blend.zaxis);
+
+	for (i = 0; i < c->num_rocks; ++i) {
+		if (prev_rock[i] < 0)
+			continue;
+		blend_point(rock[i].pos, p->rock[prev_rock[i]].pos,
+		            c->rock[i].pos, a);
+		rock[i].rot = blend_angle(p->rock[prev_rock[i]].rot,
+		              c->rock[i].rot, a);
+	}
+
+	if (c->have_target && p->have_target &&
+	    c->current_target.index == p->current_target.index &&
+	    c->current_target.generation == p->current_target.generation) {
+		vec_sub(&d, &c->target.pos, &p->target.pos);
+		if (fabs(d.x) < SNAP_MAX_STEP && fabs(d.y) < SNAP_MAX_STEP &&
+		    fabs(d.z) < SNAP_MAX_STEP)
+			vec_addmul(&blend.target.pos, &p->target.pos, a, &d);
+	}
+
+	/* a torp's prev_pos is where it was one tick before pos, so f is how
+	far the frame is into that last tick */
+	f = 1 - (1 - a) * (c->ticks - p->ticks);
+	if (f < 0)
+		f = 0;
+	for (i = 0; i < MAX_TORPS; ++i) {
+		t = &blend.torp[i];
+		vec_sub(&d, &t->pos, &t->prev_pos);
+		vec_addmul(&t->pos, &t->prev_pos, f, &d);
+		t = &blend.sorted_torp[i];
+		vec_sub(&d, &t->pos, &t->prev_pos);
+		vec_addmul(&t->pos, &t->prev_pos, f, &d);
+	}
+
+	for (i = 0; i < MAX_BLASTS; ++i) {
+		e  = &blend.explosion[i];
+		e0 = &p->explosion[i];
+		if (e->is_active && e0->is_active &&
+		    e->generation == e0->generation)
+			e->scalar = e0->scalar + a * (e->scalar - e0->scalar);
+	}
+	return;
+}
+
+/* r = p + a * (c - p), unless the rock went around the field */
+static void blend_point(float *r, const float *p, const float *c, double a)
+{
+	unsigned int k;
+
+	for (k = 0; k < 3; ++k)
+		if (fabs(c[k] - p[k]) > SNAP_MAX_STEP)
+			return;
+	for (k = 0; k < 3; ++k)
+		r[k] = p[k] + a * (c[k] - p[k]);
+	return;
+}
+
+/* The angle fraction a of the way from p to c degrees, turning the shorter
+way */
+static float blend_angle(float p, float c, double a)
+{
+	float d = fmod(c - p, 360);
+
+	if (d > 180)
+		d -= 360;
+	else if (d < -180)
+		d += 360;
+	return p + a * d;
+}
@@ -25,48 +25,107 @@
 #include "asteroids3D.h"
 #include "vecops.h"
 
-static void gen_rand_asteroid_at_pos(const Vector *, Asteroid *, int);
+/* Most fragments a rock splits into, see spawn_new_asteroids() */
+#define MAX_NEW_ROCKS 5
 
-//-----------------------------------------------------------------------------
-/* generate new asteroids at position pos smaller than type */
-void add_new_asteroids(const Vector *ppos, int type)
-{
-	static const int rocks[] = {2, 2, 2, 3, 3, 3, 3, 4, 4, 5};
-	Node *current = NULL;
-	int num_new_rocks, i;
+/* A torp is spent on its first hit, so no more rocks than there are torps
+can be hit between two calls of spawn_new_asteroids() */
+#define MAX_SPAWN_REQS MAX_TORPS
+#define MAX_SPAWN_ROCKS (MAX_SPAWN_REQS * MAX_NEW_ROCKS)
 
-	/* Decide how many new rocks to generate. Weighted to be 2 or 3. */
-	num_new_rocks = rocks[gen_rand_int(0, 9)];
-	current = al_tail;
+struct spawn_req {
+	Vector pos; // where the parent was hit
+	int type;   // the parent's type; fragments are smaller
+};
 
-	for (i = 0; i < num_new_rocks; ++i) {
-		if (current->next == NULL)
-			current->next = add_node();
+static struct spawn_req spawn_queue[MAX_SPAWN_REQS];
+static unsigned int num_spawn_reqs;
 
-		current = current->next;
-		gen_rand_asteroid_at_pos(ppos, &current->rock, type);
-	}
+/* Spawn statistics, see print_spawn_stats() */
+static unsigned long spawn_total;   // fragments added to the field
+static unsigned long spawn_batches; // non-empty spawn_new_asteroids() calls
+static unsigned long spawn_tick = ~0UL;
+static unsigned int spawn_this_tick, spawn_peak;
 
-	al_tail = current;
+//-----------------------------------------------------------------------------
+/* Queue the fragments of a rock of the given type hit at ppos. They are
+added by the next spawn_new_asteroids(). */
+void queue_new_asteroids(const Vector *ppos, int type)
+{
+	if (num_spawn_reqs == MAX_SPAWN_REQS)
+		spawn_new_asteroids();
+	spawn_queue[num_spawn_reqs].pos  = *ppos;
+	spawn_queue[num_spawn_reqs].type = type;
+	++num_spawn_reqs;
 	return;
 }
 
-
-static void gen_rand_asteroid_at_pos(const Vector *ppos, Asteroid *a,
-    int type)
+/*
+ * Add the fragments of all queued hits to the end of the field in one
+ * block, and return how many there were. The random numbers for the whole
+ * batch are drawn up front, one kind at a time.
+ */
+unsigned int spawn_new_asteroids(void)
 {
-        double k;
+	static const int rocks[] = {2, 2, 2, 3, 3, 3, 3, 4, 4, MAX_NEW_ROCKS};
+	double pick[MAX_SPAWN_ROCKS], speed[MAX_SPAWN_ROCKS],
+	       spin[MAX_SPAWN_ROCKS];
+	Vector dir[2 * MAX_SPAWN_ROCKS];
+	unsigned int num[MAX_SPAWN_REQS], n, r, i, j;
+	Asteroid a;
+	int k;
+
+	if (num_spawn_reqs == 0)
+		return 0;
 
-	a->type   = gen_rand_int(0,type-1) ;
-	a->mass   = MIN_AST_MASS + AST_MASS_K * a->type; /* based on type */
-        a->radius = static_cast(double, a->type+1) / 2; // based on type
-        a->pos    = *ppos;
+	/* Decide how many new rocks each hit gives. Weighted to be 2 or 3. */
+	gen_rand_floats(pick, num_spawn_reqs, 1, 0, 10);
+	for (r = 0, n = 0; r < num_spawn_reqs; ++r)
+		n += num[r] = rocks[static_cast(int, pick[r])];
 
-	k = gen_rand_float(0, MAX_APD);
-	gen_rand_vec(&a->velocity);
-        vec_smul(&a->velocity, &a->velocity, k);
-	a->rot = 0;
-	a->rot_delta = gen_rand_int(-MAX_ARD, MAX_ARD);
-	gen_rand_vec(&a->rot_axis);
+	if ((k = ast_alloc_n(&n)) < 0) {
+		num_spawn_reqs = 0;
+		return 0;
+	}
+
+	/* size, heading, speed, spin axis and spin rate of each fragment */
+	gen_rand_floats(pick, n, 1, 0, 1);
+	gen_rand_unit_vecs(dir, 2 * n);
+	gen_rand_floats(speed, n, 1, 0, MAX_APD);
+	gen_rand_floats(spin, n, 1, 0, 2 * MAX_ARD + 1);
+
+	a.rot = 0;
+	for (r = 0, i = 0; r < num_spawn_reqs && i < n; ++r)
+		for (j = 0; j < num[r] && i < n; ++j, ++i) {
+			a.type   = static_cast(int, pick[i] * spawn_queue[r].type);
+			a.mass   = AST_MASS(a.type);
+			a.radius = AST_RADIUS(a.type);
+			a.pos    = spawn_queue[r].pos;
+			vec_smul(&a.velocity, &dir[2*i], speed[i]);
+			a.rot_delta = static_cast(int, spin[i]) -
+			              static_cast(int, MAX_ARD);
+			a.rot_axis  = dir[2*i+1];
+			ast_store(k + i, &a);
+		}
+	num_spawn_reqs = 0;
+
+	++spawn_batches;
+	spawn_total += n;
+	if (spawn_tick != ticks) {
+		spawn_tick = ticks;
+		spawn_this_tick = 0;
+	}
+	spawn_this_tick += n;
+	if (spawn_this_tick > spawn_peak)
+		spawn_peak = spawn_this_tick;
+	return n;
+}
+
+void print_spawn_stats(void)
+{
+	printf("Fragments: %lu spawned in %lu batches, %.2f per tick, "
+	       "peak %u in one tick\n", spawn_total, spawn_batches,
+	       (ticks > 0) ? static_cast(double, spawn_total) / ticks : 0,
+	       spawn_peak);
 	return;
 }
@@ -28,6 +28,31 @@ typedef struct vector {
     double x, y, z, w;
 } Vector;
 
+/* Element of the asteroid field's vector arrays. Building with
+ * -DAST_FLOAT32 (e.g. "make CPPFLAGS=-DAST_FLOAT32") halves them to four
+ * floats, see asteroid.c; w is unused either way. */
+#ifdef AST_FLOAT32
+typedef struct ast_vec {
+    float x, y, z, w;
+} AstVec;
+#else
+typedef Vector AstVec;
+#endif
+
+/* Rotation as a unit quaternion w + xi + yj + zk */
+typedef struct quat {
+    double w, x, y, z;
+} Quat;
+
+/* Generational reference to a pooled entity. index names its place in the
+ * pool and generation which of the entities to use that place is meant, so
+ * a handle stops resolving once its entity is gone, even after the place
+ * is reused. */
+typedef struct handle {
+    unsigned int index;
+    unsigned int generation;
+} Handle;
+
 typedef struct asteroid {
     double mass;        // BASED ON TYPE
     int    type;        // which asteroid display list to use
@@ -45,6 +70,7 @@ typedef struct torpedo {
     int trail_num;
     double ttl; // time to live
     Vector pos;
+    Vector prev_pos;  // position at the start of the last tick
     Vector pos_delta;
     // the number of degrees to rotate the torp billboard about the z axis
     int bb_zrot;
@@ -58,10 +84,55 @@ typedef struct torpedo_trail {
     Vector pos[TORP_TRAIL_LEN];
 } TorpedoTrail;
 
-typedef struct node {
-    Asteroid rock;
-    struct node *next;
-} Node;
+/* Dense structure-of-arrays asteroid storage. Element i of every array
+ * describes the same rock; mass and radius are derived from the type.
+ * pos, velocity and type are read by every motion and collision pass and
+ * come first in the slab, the rest only when drawing or on a hit. Go
+ * through ast_pos() and friends for the vectors, which are stored relative
+ * to origin in the AST_FLOAT32 layout. */
+typedef struct asteroid_field {
+    unsigned int count;     // number of live asteroids
+    unsigned int capacity;  // pool size: number of slots in each array
+    unsigned int peak;      // highest count seen so far
+    unsigned long alloc_failures; // ast_alloc() calls on a full pool
+    void   *slab;           // single allocation backing all arrays
+    Vector origin;          // pos is relative to this, see ast_rebase()
+    AstVec *pos;            // current position
+    AstVec *velocity;       // vector along which asteroid moves
+    int    *type;           // which asteroid display list to use
+    AstVec *rot_axis;       // axis asteroid rotates around
+    int    *rot;            // current degrees of rotation
+    int    *rot_delta;      // degress to rotate per unit time
+    unsigned char *tier;    // simulation LOD tier, see move_asteroids()
+    unsigned char *lag;     // ticks of motion not yet applied to pos
+    /* Handles go through an id per asteroid, which stays put while the
+     * asteroid moves around the arrays; ids [count, capacity) are free. */
+    unsigned int *id;       // id of each asteroid
+    unsigned int *id_index; // where the asteroid with each id is
+    unsigned int *id_generation; // bumped when an id's asteroid dies
+} AsteroidField;
+
+/* Body of a data-parallel loop: handles elements [first, last), which make
+ * up the given chunk of the job, see run_parallel() */
+typedef void (*WorkFunc)(unsigned int chunk, unsigned int first,
+    unsigned int last);
+
+/* A unit of work for the job system, see workers.c. A job counts as
+ * finished once its function has returned and all its children (the jobs
+ * created with it as their parent) have finished. */
+typedef void (*JobFunc)(void *);
+typedef struct job {
+    JobFunc func;               // may be NULL for a job that only groups others
+    void   *arg;
+    struct job *parent;
+    unsigned int unfinished;    // this job and its children not yet finished
+} Job;
+
+/* Integrate-and-wrap kernel: moves n positions along their velocities by
+ * the time step and wraps them around the torus at the center, see
+ * integrate.c */
+typedef void (*IntegrateFunc)(AstVec *, const AstVec *, unsigned int n,
+    double step, const Vector *center);
 
 typedef struct blast {
     int    is_active;
@@ -69,6 +140,8 @@ typedef struct blast {
     Vector pos;
     float  scalar;
     int    type; // which explosion display list to use
+    unsigned int generation; // bumped each time the slot is activated,
+                             // so snapshots tell one blast from the next
 } Blast;
 
 typedef struct wind_part {
@@ -77,6 +150,71 @@ typedef struct wind_part {
     double t_start, t_end;      // time to start/end
 } WindPart;
 
+/* What a GLUT callback saw, queued for the sim thread, see input.c */
+typedef struct input_event {
+    int    type;    // INPUT_*
+    int    code;    // key or mouse button
+    int    x, y;    // pointer position, or window size
+    double stamp;   // monotonic clock time of the callback, in seconds
+} InputEvent;
+
+/* Vertex of an asteroid shape, see models.c */
+typedef struct rock_vertex {
+    float pos[3];
+    float normal[3];
+    float tc[2];
+} RockVertex;
+
+/* An asteroid shape as triangles, shared by its display list and the
+ * vertex buffers of instance.c. Under flat shading, each triangle takes
+ * the normal of its last vertex. */
+typedef struct rock_mesh {
+    RockVertex *vertex;
+    unsigned short *index;  // three per triangle
+    unsigned int num_vertices, num_indices;
+    float scale;            // the shape is drawn that many times as large
+} RockMesh;
+
+/* An asteroid as the renderer needs it */
+typedef struct snap_rock {
+    float pos[3];
+    float rot_axis[3];
+    float rot;
+    int   type;
+    unsigned int id, generation; // which rock it is, see ast_handle()
+} SnapRock;
+
+/* Everything display() draws, copied out of the sim at the end of a tick.
+ * The sim thread publishes a new one every tick, see snapshot.c; the
+ * members are named after the globals they come from. */
+typedef struct render_snapshot {
+    unsigned long ticks;    // tick count when it was taken
+    double stamp;           // when the tick was due, monotonic clock seconds
+    double view[16];        // modelview matrix of the eye, see view_matrix()
+    Vector pos, xaxis, yaxis, zaxis, velocity;
+    Quat orient;            // the eye's orientation, see view_orient()
+    SnapRock *rock;         // the asteroids in front of the eye
+    unsigned int num_rocks;
+    int have_target;        // is target valid
+    Handle current_target;
+    Asteroid target;        // the targeted asteroid
+    Torpedo torp[MAX_TORPS];
+    Torpedo sorted_torp[MAX_TORPS];
+    TorpedoTrail torp_trail[MAX_TORP_TRAILS];
+    Blast explosion[MAX_BLASTS];
+    WindPart winshield_particle[MAX_BLASTS * NUM_WP_PER_BLAST];
+    Vector dust_part[NUM_DUST_PART][NUM_CHILD_DUST_PART];
+    int torps_in_flight_flag, tracer_light_flag, explosions_active_flag;
+    int expl_winshield_particle_count, shield_activated_flag;
+    int draw_shield_flag;   // optmap's, the sim reads it too
+    float shield_strength;
+    int cwg_rear, cwg_above, cwg_below, cwg_left, cwg_right;
+    double flicker_hud_ttl;
+    unsigned int score;
+    int num_asteroids_on_scanner;
+    double achieved_tps;
+} RenderSnapshot;
+
 typedef struct keyboard_map {
     char
 
@@ -107,6 +245,7 @@ typedef struct keyboard_map {
     torp_texture_toggle,
     axes_toggle,
     play_sound_toggle,
+    rock_collision_toggle,
     reverse_mouse_x_toggle, reverse_mouse_y_toggle
     ;
 } KeyboardMap;
@@ -124,15 +263,22 @@ typedef struct user_options_map {
     int play_sound_flag;         // should sound be used
     int torp_texture_flag;       // should the torps be textured
     int draw_torp_lensflare_flag; // should the torp lens flares be drawn
+    int rock_collision_flag;     // should the asteroids bounce off each other
+    int sim_lod_flag;            // should far asteroids be updated less often
+    int interpolate_flag;        // should frames be blended between ticks
+    int instancing_flag;         // should asteroids be drawn by instancing, see instance.c
+    int vsync_flag;              // should buffer swaps wait for the vertical retrace
 
     // more user preferences
     double mouse_xdir;  // 1 = mouse movement turns the normal direction, -1 = mouse movement turns opposite direction (should be -1 or 1 only)
     double mouse_ydir;  // 1 = mouse movement turns the normal direction, -1 = mouse movement turns opposite direction (should be -1 or 1 only)
     int num_asteroids;  // number of asteroids, set by #define or command line
+    unsigned int max_asteroids; // asteroid pool size (high-water mark), 0 = automatic
     int windowx;        // window x size, changed in reshape(). set by #define or on command line
     int windowy;        // window y size, changed in reshape(). set by #define or on command line
     int window_xpos;    // window left corner x offset
     int window_ypos;    // window left corner y offset
+    unsigned int max_fps; // frames per second cap, 0 = none
 
     // 0=cube, 1=octahedron, 2=sphere, 3=tetrahedron
     unsigned int target_box_type;
@@ -282,12 +282,12 @@ void draw_sun_lensflares(void)
 	sun.z = l0_pos[2];
 	vec_sdiv(&sun, &sun, vec_length(&sun));
 
-	if (vec_dot(&sun, &zaxis) < MIN_VIEW_ANGLE)
+	if (vec_dot(&sun, &snapshot->zaxis) < MIN_VIEW_ANGLE)
 		return;
 
 	// Set the final sun flare position
-	flare_pos.x = vec_dot(&xaxis, &sun);
-	flare_pos.y = -vec_dot(&yaxis, &sun);
+	flare_pos.x = vec_dot(&snapshot->xaxis, &sun);
+	flare_pos.y = -vec_dot(&snapshot->yaxis, &sun);
 	flare_pos.z = -1;
 
 	// Draw the flares
@@ -319,19 +319,20 @@ void draw_torp_lensflares(void)
 	/* NOTE that the torps array is run through in the REVERSE order because
 	of the sorting/alpha blending effect. */
 	for (i = MAX_TORPS - 1; i >= 0; --i) {
-		if (!sorted_torp[i].in_flight_flag)
+		if (!snapshot->sorted_torp[i].in_flight_flag)
 			continue;
 
-		vec_sub(&torp_pos, &sorted_torp[i].pos, &pos);
+		vec_sub(&torp_pos, &snapshot->sorted_torp[i].pos,
+		        &snapshot->pos);
 		len = vec_length(&torp_pos);
 		vec_sdiv(&torp_pos, &torp_pos, len);
 
-		if (vec_dot(&torp_pos, &zaxis) < MIN_VIEW_ANGLE)
+		if (vec_dot(&torp_pos, &snapshot->zaxis) < MIN_VIEW_ANGLE)
 			continue;
 
 		// Set the final torp flare position
-		flare_pos.x = vec_dot(&xaxis, &torp_pos);
-		flare_pos.y = -vec_dot(&yaxis, &torp_pos);
+		flare_pos.x = vec_dot(&snapshot->xaxis, &torp_pos);
+		flare_pos.y = -vec_dot(&snapshot->yaxis, &torp_pos);
 		flare_pos.z = -1;
 
 		// Draw the flares
@@ -343,8 +344,9 @@ void draw_torp_lensflares(void)
 		for (j = 0; j < MAX_FLARES; ++j) {
 			glPushMatrix();
 			// Set the transparency of the flare
-			fade[3] = (sorted_torp[i].ttl - ticks) *
-					  torp_flare[j].a / (TORP_TTL * tps);
+			fade[3] = (snapshot->sorted_torp[i].ttl -
+			          snapshot->ticks) * torp_flare[j].a /
+			          (TORP_TTL * tps);
 			glMaterialfv(GL_FRONT,GL_AMBIENT_AND_DIFFUSE,fade);
 			glTranslatef(flare_pos.x * torp_flare[j].pos_scalar,
 			             flare_pos.y * torp_flare[j].pos_scalar,
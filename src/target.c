@@ -28,9 +28,6 @@
 #include "asteroids3D.h"
 #include "vecops.h"
 
-// A pointer to, well, that's pretty obvious
-Node *currently_targeted_asteroid = NULL;
-
 // Target box display list
 static int target_box_dl, target_circle_dl, target_arrow_on_dl,
     target_arrow_off_dl, target_steering_cue_dl;
@@ -38,30 +35,31 @@ static int target_box_dl, target_circle_dl, target_arrow_on_dl,
 //-----------------------------------------------------------------------------
 void auto_target_asteroid(void)
 {
-	Node *target[NUM_AST_TYPES] = {}, *current = NULL;
+	int target[NUM_AST_TYPES];
 	int i, num_targets_found = 0;
+	unsigned int n;
 
-	/* The idea here is that I'm going to scan the linked list for
+	/* The idea here is that I'm going to scan the asteroid field for
 	 * a target of each target type, and fill up the targets
-	 * array with pointers to each target type.
+	 * array with the index of each target type.
 	 *
-	 * Then I'm going to lock on to the smallest non-null target type.
+	 * Then I'm going to lock on to the smallest non-empty target type.
 	 */
-	current = al_head->next;
+	for (i = 0; i < NUM_AST_TYPES; ++i)
+		target[i] = NO_TARGET;
 
-	while (current != NULL) {
-		if (target[current->rock.type] == NULL) {
-			target[current->rock.type] = current;
+	ast_foreach(n) {
+		if (target[afield.type[n]] == NO_TARGET) {
+			target[afield.type[n]] = n;
 			++num_targets_found;
 		}
 		if (num_targets_found == NUM_AST_TYPES) /* all slots filled */
 			break;
-		current = current->next;
 	}
 
 	for (i = 0; i < NUM_AST_TYPES; ++i)
-		if (target[i] != NULL) {
-			currently_targeted_asteroid = target[i];
+		if (target[i] != NO_TARGET) {
+			ast_handle(&current_target, target[i]);
 			play_sound(SOUND_TARGET_AQUIRED, 0);
 			break;
 		}
@@ -71,32 +69,30 @@ void auto_target_asteroid(void)
 
 void target_asteroid(void)
 {
-	Node *current = NULL, *candidate = NULL;
-	Vector temp1, temp2, point_onz;
+	int candidate = NO_TARGET;
+	Vector temp1, temp2, point_onz, p;
 	double dist_alongz, dist_fromz;
+	unsigned int n;
 
-	current = al_head->next;
-
-	while (current != NULL) {
-		vec_sub(&temp1, &current->rock.pos, &pos);
+	ast_foreach(n) {
+		ast_pos(&p, n);
+		vec_sub(&temp1, &p, &pos);
 		dist_alongz = vec_dot(&zaxis, &temp1);
 		vec_smul(&point_onz, &zaxis, dist_alongz);
 		vec_sub(&temp2, &point_onz, &temp1);
 		dist_fromz = vec_length(&temp2);
 
 		/* this test isn't precisely correct, but it works well */
-		if (dist_fromz < current->rock.radius * 2)
-		    candidate = current;
-
-		current = current->next;
+		if (dist_fromz < AST_RADIUS(afield.type[n]) * 2)
+		    candidate = n;
 	}
 
-	if (candidate == NULL) {
-		currently_targeted_asteroid = NULL;
+	if (candidate == NO_TARGET) {
+		current_target = NO_HANDLE;
 		return;
 	}
 
-	currently_targeted_asteroid = candidate;
+	ast_handle(&current_target, candidate);
 	play_sound(SOUND_TARGET_AQUIRED, 0);
 	return;
 }
@@ -227,18 +223,18 @@ void draw_lcs(const Asteroid *a)
 	double tv_mag, distance, k, r, s, t, scalar;
 	Vector temp, apos, tpos;
 
-	vec_smul(&torp_vel, &zaxis, TORP_DELTA);
+	vec_smul(&torp_vel, &snapshot->zaxis, TORP_DELTA);
 	tv_mag = vec_length(&torp_vel);
-	k = pos.x - a->pos.x;
-	r = pos.y - a->pos.y;
-	s = pos.z - a->pos.z;
+	k = snapshot->pos.x - a->pos.x;
+	r = snapshot->pos.y - a->pos.y;
+	s = snapshot->pos.z - a->pos.z;
 
 	distance = vp_length(k, r, s);
 	t = distance / tv_mag;
 
 	vec_addmul(&ast_pos, &a->pos, t, &a->velocity);
-	vec_add(&temp, &torp_vel, &velocity);
-	vec_addmul(&torp_pos, &pos, t, &temp);
+	vec_add(&temp, &torp_vel, &snapshot->velocity);
+	vec_addmul(&torp_pos, &snapshot->pos, t, &temp);
 
 /* this commented out section was my first cut at the lead
  * computing sight, it actually plots the predicted asteroid
@@ -263,10 +259,10 @@ void draw_lcs(const Asteroid *a)
 	/* calculate the projection of the future asteroid
 	 * position on to the screen plane
 	 */
-	vec_sub(&temp, &ast_pos, &pos);
-	apos.x = -vec_dot(&xaxis, &temp);
-	apos.y = vec_dot(&yaxis, &temp);
-	apos.z = vec_dot(&zaxis, &temp);
+	vec_sub(&temp, &ast_pos, &snapshot->pos);
+	apos.x = -vec_dot(&snapshot->xaxis, &temp);
+	apos.y = vec_dot(&snapshot->yaxis, &temp);
+	apos.z = vec_dot(&snapshot->zaxis, &temp);
 
 	/* perspective scale apos, then set apos.z to be the screen plane .
 	 * NOTE: that to perspective scale apos, you don't want to divide by
@@ -282,10 +278,10 @@ void draw_lcs(const Asteroid *a)
 	/* calculate the projection of the future torpedo
 	 * position on to the screen plane
 	 */
-	vec_sub(&temp, &torp_pos, &pos);
-	tpos.x = -vec_dot(&xaxis, &temp);
-	tpos.y = vec_dot(&yaxis, &temp);
-	tpos.z = vec_dot(&zaxis, &temp);
+	vec_sub(&temp, &torp_pos, &snapshot->pos);
+	tpos.x = -vec_dot(&snapshot->xaxis, &temp);
+	tpos.y = vec_dot(&snapshot->yaxis, &temp);
+	tpos.z = vec_dot(&snapshot->zaxis, &temp);
 
 	/* once again, perspective scale apos, then set apos.z to be the screen plane .*/
 	tpos.x /= tpos.z;
@@ -313,11 +309,12 @@ void draw_lcs(const Asteroid *a)
 		temp.x = -k;
 		temp.y = -r;
 		temp.z = -s;
-		if (vec_dot(&temp, &zaxis) >= 0) {
+		if (vec_dot(&temp, &snapshot->zaxis) >= 0) {
 			scalar = (TORP_RADIUS + a->radius) / distance;
 			glTranslatef(apos.x, apos.y, apos.z);
 			glScalef(scalar, scalar, scalar);
-			glRotatef(10 * vec_dist(&pos, &a->pos), 0, 0, 1);
+			glRotatef(10 * vec_dist(&snapshot->pos, &a->pos),
+			          0, 0, 1);
 			glEnable(GL_BLEND);
 			glCallList(target_circle_dl);
 			glDisable(GL_BLEND);
@@ -333,15 +330,15 @@ void draw_steering_cue(const Asteroid *a)
 	double k, theta;
 
 	/* asteroid position relative to the ship */
-	vec_sub(&ast_pos, &a->pos, &pos);
+	vec_sub(&ast_pos, &a->pos, &snapshot->pos);
 
 	/* don't want to draw the steering cue if the asteroid
 	 * is close to the sight already
 	 */
 	vec_sdiv(&u_ast_pos, &ast_pos, vec_length(&ast_pos));
 
-	theta = acos(vec_dot(&zaxis, &u_ast_pos)) * 180 / M_PI;
-	if (theta < 30 && vec_dot(&zaxis, &u_ast_pos) > 0)
+	theta = acos(vec_dot(&snapshot->zaxis, &u_ast_pos)) * 180 / M_PI;
+	if (theta < 30 && vec_dot(&snapshot->zaxis, &u_ast_pos) > 0)
 		return;
 
 	/* okay, made it here so calculate the spot to
@@ -350,20 +347,20 @@ void draw_steering_cue(const Asteroid *a)
 	 */
 
 	/* distance of asteroid vector along ship's z axis */
-	k = vec_dot(&zaxis, &ast_pos);
+	k = vec_dot(&snapshot->zaxis, &ast_pos);
 
 	/* vector along z axis the length of k */
-	vec_smul(&temp1, &zaxis, k);
+	vec_smul(&temp1, &snapshot->zaxis, k);
 
 	/* vector from zaxis to asteroid */
 	vec_sub(&temp2, &ast_pos, &temp1);
 	vec_sdiv(&temp2, &temp2, vec_length(&temp2));
 
-	theta = acos(vec_dot(&temp2, &xaxis)) * 180 / M_PI;
+	theta = acos(vec_dot(&temp2, &snapshot->xaxis)) * 180 / M_PI;
 
-	if (vec_dot(&ast_pos, &yaxis) < 0)
+	if (vec_dot(&ast_pos, &snapshot->yaxis) < 0)
 		theta += 180;
-	if (vec_dot(&ast_pos, &yaxis) > 0)
+	if (vec_dot(&ast_pos, &snapshot->yaxis) > 0)
 		theta = 180 - theta;
 
 	glPushMatrix();
@@ -374,18 +371,3 @@ void draw_steering_cue(const Asteroid *a)
 	glPopMatrix();
 	return;
 }
-
-/* return 1 if the asteroid IS targeted, return zero if it is NOT */
-int is_targeted(const Asteroid *a)
-{
-	const Node *c = currently_targeted_asteroid;
-	return c != NULL && a->pos.x == c->rock.pos.x &&
-	       a->pos.y == c->rock.pos.y && a->pos.z == c->rock.pos.z &&
-	       a->type == c->rock.type;
-}
-
-void drop_target(void)
-{
-	currently_targeted_asteroid = NULL;
-	return;
-}
@@ -28,6 +28,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include "asteroids3D.h"
 
 typedef struct ppm_file {
@@ -37,35 +38,78 @@ typedef struct ppm_file {
 	int dim[2];
 } PPM_file;
 
+/* What the textures are used for, which decides how they are uploaded */
+#define TEX_ASTEROID 0
+#define TEX_NEBULA   1
+#define TEX_TORP     2
+
+/* A texture file, decoded by a job and uploaded by init_textures() */
+struct tex_load {
+	const char *file;
+	int kind;               // TEX_*
+	unsigned int *tex;      // texture object to upload to
+	/* Filled in by decode_texture() */
+	void *pixels;           // RGB, or RGBA for TEX_TORP; malloc'ed
+	long flen;
+	int dim[2];
+	double secs;            // time taken to decode
+};
+
 static char *add_alpha_channel_to_RGB_image(const unsigned char *, int, int);
 static void average_RGBA_alpha_and_floor(unsigned char *, int, int, int);
+static void decode_texture(void *);
 static int ppm_open(const char *, PPM_file *);
 static void ppm_close(PPM_file *);
-static void rd_ast(const char *, int);
-static void rd_neb(const char *, int);
-static void rd_torp(const char *);
+static void upload_texture(const struct tex_load *);
+
+static struct tex_load tex_load[] = {
+	{"ast_tex0.ppm",    TEX_ASTEROID, &ast_tex[0]},
+	{"ast_tex1.ppm",    TEX_ASTEROID, &ast_tex[1]},
+	{"ast_tex2.ppm",    TEX_ASTEROID, &ast_tex[2]},
+	{"ast_tex3.ppm",    TEX_ASTEROID, &ast_tex[3]},
+	{"ast_tex4.ppm",    TEX_ASTEROID, &ast_tex[4]},
+	{"ast_tex5.ppm",    TEX_ASTEROID, &ast_tex[5]},
+	{"nebula_tex0.ppm", TEX_NEBULA,   &nebula_tex[0]},
+	{"nebula_tex1.ppm", TEX_NEBULA,   &nebula_tex[1]},
+	{"nebula_tex2.ppm", TEX_NEBULA,   &nebula_tex[2]},
+	{"nebula_tex3.ppm", TEX_NEBULA,   &nebula_tex[3]},
+	{"torp_tex0.ppm",   TEX_TORP,     &torp_tex},
+};
+
+#define NUM_TEX_LOADS (sizeof(tex_load) / sizeof(*tex_load))
 
 // Nebula billboard texture object list, and nebula display list
 int nebula_dl[NUM_NEBULA_TEX];
 unsigned int nebula_tex[NUM_NEBULA_TEX];
 
 //-----------------------------------------------------------------------------
+/* Have the job system read and decode the texture files, one job each, as
+children of parent. Reading a file needs no GL context, so this can happen
+while the main thread builds the display lists. */
+void load_textures(Job *parent)
+{
+	unsigned int i;
+
+	for (i = 0; i < NUM_TEX_LOADS; ++i)
+		submit_job(create_job(decode_texture, &tex_load[i], parent));
+	return;
+}
+
+/* Upload the textures decoded by load_textures() to GL. Must be called on
+the thread with the GL context, once their jobs have finished. */
 void init_textures(void)
 {
-	printf("Reading asteroid textures\n");
-	rd_ast("ast_tex0.ppm", 0);
-	rd_ast("ast_tex1.ppm", 1);
-	rd_ast("ast_tex2.ppm", 2);
-	rd_ast("ast_tex3.ppm", 3);
-	rd_ast("ast_tex4.ppm", 4);
-	rd_ast("ast_tex5.ppm", 5);
-	printf("Reading nebula textures\n");
-	rd_neb("nebula_tex0.ppm", 0);
-	rd_neb("nebula_tex1.ppm", 1);
-	rd_neb("nebula_tex2.ppm", 2);
-	rd_neb("nebula_tex3.ppm", 3);
-	printf("Reading torpedo texture\n");
-	rd_torp("torp_tex0.ppm");
+	unsigned int i;
+
+	printf("Uploading textures\n");
+	for (i = 0; i < NUM_TEX_LOADS; ++i) {
+		upload_texture(&tex_load[i]);
+		printf("  [%02u] %s (%ld bytes, %dx%d, decoded in %.1f ms)\n", i,
+		       tex_load[i].file, tex_load[i].flen, tex_load[i].dim[0],
+		       tex_load[i].dim[1], tex_load[i].secs * 1000);
+		free(tex_load[i].pixels);
+		tex_load[i].pixels = NULL;
+	}
 
 	/* now, bind to the special texture 0 to turn off texturing intially.
 	 */
@@ -73,6 +117,58 @@ void init_textures(void)
 	return;
 }
 
+/* Job: read one texture file into memory of our own */
+static void decode_texture(void *arg)
+{
+	struct tex_load *t = arg;
+	struct timespec t0, t1;
+	PPM_file data;
+	size_t size;
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	if (ppm_open(t->file, &data) <= 0)
+		exit(EXIT_FAILURE);
+
+	if (t->kind == TEX_TORP) {
+		t->pixels = add_alpha_channel_to_RGB_image(data.image,
+		            data.dim[0], data.dim[1]);
+		average_RGBA_alpha_and_floor(t->pixels, data.dim[0],
+		    data.dim[1], 90);
+	} else {
+		size = static_cast(size_t, data.dim[0]) * data.dim[1] * 3;
+		if ((t->pixels = malloc(size)) == NULL) {
+			perror("malloc");
+			exit(EXIT_FAILURE);
+		}
+		memcpy(t->pixels, data.image, size);
+	}
+
+	t->flen   = data.flen;
+	t->dim[0] = data.dim[0];
+	t->dim[1] = data.dim[1];
+	ppm_close(&data);
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	t->secs = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+	return;
+}
+
+static void upload_texture(const struct tex_load *t)
+{
+	GLenum format = (t->kind == TEX_TORP) ? GL_RGBA : GL_RGB;
+
+	glGenTextures(1, t->tex);
+	glBindTexture(GL_TEXTURE_2D, *t->tex);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	if (t->kind == TEX_ASTEROID) {
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	}
+	glTexImage2D(GL_TEXTURE_2D, 0, format, t->dim[0], t->dim[1], 0,
+	             format, GL_UNSIGNED_BYTE, t->pixels);
+	return;
+}
+
 static char *add_alpha_channel_to_RGB_image(const unsigned char *image,
     int x, int y)
 {
@@ -146,8 +242,11 @@ static int ppm_open(const char *name, PPM_file *data)
 			break;
 
 	sscanf(buf, "%d %d", &data->dim[0], &data->dim[1]);
-	if (data->dim[0] < 1 || data->dim[1] < 1)
+	if (data->dim[0] < 1 || data->dim[1] < 1) {
+		fprintf(stderr, "Bad image size in %s\n", name);
+		fclose(data->fptr);
 		return 0;
+	}
 	fgets(buf, sizeof(buf), data->fptr); // color thingie
 	data->i_off = ftell(data->fptr);
 
@@ -169,64 +268,3 @@ static void ppm_close(PPM_file *data)
 	fclose(data->fptr);
 	return;
 }
-
-static void rd_ast(const char *file, int spot)
-{
-	PPM_file data;
-
-	if (ppm_open(file, &data) < 0)
-		exit(EXIT_FAILURE);
-	glGenTextures(1, &ast_tex[spot]);
-	glBindTexture(GL_TEXTURE_2D, ast_tex[spot]);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-	//glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, data.dim[0], data.dim[1], 0,
-	             GL_RGB, GL_UNSIGNED_BYTE, data.image);
-	ppm_close(&data);
-
-	printf("  [%02d] %s (%ld bytes, %dx%d)\n",
-	       spot, file, data.flen, data.dim[0], data.dim[1]);
-	return;
-}
-
-static void rd_neb(const char *file, int spot)
-{
-	PPM_file data;
-
-	if (ppm_open(file, &data) < 0)
-		exit(EXIT_FAILURE);
-	glGenTextures(1, &nebula_tex[spot]);
-	glBindTexture(GL_TEXTURE_2D, nebula_tex[spot]);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	//glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_DECAL);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, data.dim[0], data.dim[1], 0,
-	             GL_RGB, GL_UNSIGNED_BYTE, data.image);
-	ppm_close(&data);
-
-	printf("  [%02d] %s (%ld bytes, %dx%d)\n",
-	       spot, file, data.flen, data.dim[0], data.dim[1]);
-	return;
-}
-
-static void rd_torp(const char *file)
-{
-	PPM_file data;
-
-	if (ppm_open(file, &data) < 0)
-		exit(EXIT_FAILURE);
-	glGenTextures(1, &torp_tex);
-	glBindTexture(GL_TEXTURE_2D, torp_tex);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	data.uptr = add_alpha_channel_to_RGB_image(data.image, data.dim[0], data.dim[1]);
-	average_RGBA_alpha_and_floor(data.uptr, data.dim[0], data.dim[1], 90);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, data.dim[0], data.dim[1], 0,
-	             GL_RGBA, GL_UNSIGNED_BYTE, data.uptr);
-	free(data.uptr);
-	ppm_close(&data);
-	return;
-}
@@ -136,9 +136,8 @@ void process_motion(int value)
 	 * the users's rotation request is fullfilled. That's the way real life
 	 * works, but who lives in reality anyway ?
 	 */
-	rotate_view_aboutx(rotation.x * dt);
-	rotate_view_abouty(rotation.y * dt);
-	rotate_view_aboutz(rotation.z * dt);
+	vec_smul(&rotation, &rotation, dt);
+	rotate_view(&rotation);
 
 	vec_zero(&rotation);
 	return;
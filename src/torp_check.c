@@ -0,0 +1,133 @@
+/* Asteroids3D - a first person game of blowing up asteroids
+ * Copyright (C) 2000 Stuart Mark Pomerantz <smp [at] psc edu>
+ * Copyright © Jan Engelhardt <jengelh [at] gmx de>, 2003 - 2006
+ *
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  Stuart Pomerantz
+ *  3935 Stonecliffe drive
+ *  Monroeville, PA 15146
+ */
+
+/*
+ * torp_check: fires scripted shots at a lone type-0 rock through
+run_sim_tick() at several tick rates, with the ship at rest and at speed.
+Each shot is aimed at a point of the disc around the rock that a torp hits,
+at a range of 12 to 28 units, and must destroy the rock. Each shot of a
+second set passes just outside that disc and must leave it alone. A torp
+moves further than the rock is wide in one tick at the lower rates, so this
+fails if torps are tested only where they end up each tick.
+ *
+ * Exits with EXIT_FAILURE if any shot went wrong. "make check" runs it.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "asteroids3D.h"
+#include "vecops.h"
+
+#define CHECK_SHOTS 400 // shots of each set per tick rate and ship speed
+
+static int fire_shot(unsigned int, double, double);
+
+//-----------------------------------------------------------------------------
+int main(void)
+{
+	static const double rates[] = {60, 30, 15, 10, 5};
+	static const double speeds[] = {0, 40};
+	/* a torp hits within 2 * TORP_RADIUS + AST_RADIUS(0) = 1.5 */
+	static const double reach = 2 * TORP_RADIUS + AST_RADIUS(0);
+	unsigned int r, s, k, hits, misses, failed = 0;
+	double offset;
+
+	rng_seed(1);
+	rng_select(RNG_SIM);
+	init_workers(1);
+	optmap.num_asteroids = 1;
+	optmap.play_sound_flag = 0;
+	reset_view();
+	init_thrust();
+	init_torps();
+	init_asteroids();
+	init_shield();
+	init_explosions();
+
+	for (r = 0; r < sizeof(rates) / sizeof(*rates); ++r)
+		for (s = 0; s < sizeof(speeds) / sizeof(*speeds); ++s) {
+			tps = rates[r];
+			dt  = 1 / tps;
+			hits = misses = 0;
+			for (k = 0; k < CHECK_SHOTS; ++k) {
+				/* spread evenly over the disc, then over a
+				ring 0.05 to 2.05 outside of it */
+				offset = (reach - 0.05) *
+				         sqrt((k + 0.5) / CHECK_SHOTS);
+				hits += fire_shot(k, offset, speeds[s]);
+				offset = reach + 0.05 + 2.0 * k / CHECK_SHOTS;
+				misses += !fire_shot(k, offset, speeds[s]);
+			}
+			printf("tps %2.0f, ship speed %2.0f: %3u/%u shots hit, "
+			       "%3u/%u near misses missed\n", tps, speeds[s],
+			       hits, CHECK_SHOTS, misses, CHECK_SHOTS);
+			if (hits < CHECK_SHOTS || misses < CHECK_SHOTS)
+				failed = 1;
+		}
+
+	if (failed)
+		fprintf(stderr, "Some torpedo shots went wrong\n");
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+/* Put a type-0 rock offset units to the side of the line of fire, fire at
+it with the ship going at speed and run the ticks until the torp is spent.
+Returns whether the rock was destroyed. */
+static int fire_shot(unsigned int k, double offset, double speed)
+{
+	double angle = 2 * M_PI * 7 * k / CHECK_SHOTS;
+	unsigned long end;
+	Asteroid a;
+	int i;
+
+	while (afield.count > 0)
+		ast_remove(0);
+	init_torps();
+	reset_view();
+	vec_smul(&velocity, &zaxis, speed);
+
+	memset(&a, 0, sizeof(a));
+	vec_addmul(&a.pos, &pos, 12 + k % 17, &zaxis);
+	vec_addmul(&a.pos, &a.pos, offset * cos(angle), &xaxis);
+	vec_addmul(&a.pos, &a.pos, offset * sin(angle), &yaxis);
+	if ((i = ast_alloc()) < 0)
+		return 0;
+	ast_store(i, &a);
+
+	fire_torpedo();
+	end = ticks + TORP_TTL * tps + 2;
+	while (ticks < end && afield.count > 0)
+		run_sim_tick();
+	return afield.count == 0;
+}
+
+/* The shield calls this once it is gone, which a ship flying into the rock
+of a near miss can do. Here the ship just gets a fresh shield. */
+void end_game(void)
+{
+	shield_strength = MAX_SHIELD;
+	return;
+}
@@ -22,7 +22,6 @@
  *  Monroeville, PA 15146
  */
 
-#include <GL/glut.h>
 #include <stdlib.h>
 #include <string.h>
 #include "asteroids3D.h"
@@ -39,9 +38,6 @@ Torpedo torp[MAX_TORPS];
 // Doing this so alpha blending works correctly, this is scratch space.
 Torpedo sorted_torp[MAX_TORPS];
 
-int torp_dl;           // torpedo display list
-int torp_billboard_dl; // billboard for torpedo texture
-unsigned int torp_tex; // torpedo billboard texture
 int torps_in_flight_flag = 0; // are any torpedos in flight
 int tracer_light_flag = 0;    // turn on the tracer light
 
@@ -76,15 +72,7 @@ static int get_free_torpedo_trail(void)
 
 void init_torpedo(void)
 {
-	static const float emit0[]    = {1.0,  1.0, 1.0, 1.0}; /* torp material properties */
-	static const float ad0[]      = {0.0,  0.0, 0.0, 1.0};
-	static const float emit1[]    = {1.0,  1.0, 1.0, 1.0};
-	static const float ad1[]      = {0.0,  0.0, 0.0, 0.4};
-	static const float emit2[]    = {0.0,  0.6, 1.0, 1.0};
-	static const float ad2[]      = {0.0,  0.0, 0.0, 0.3};
-	static const float emit_off[] = {0.0 , 0.0, 0.0, 1.0};
-	static const float diffuse[]  = {0.0,  0.6, 1.0, 1.0}; /* tracer light property */
-	int i, k;
+	int i;
 
 	torps_in_flight_flag = 0;
 	tracer_light_flag    = 0;
@@ -95,48 +83,6 @@ void init_torpedo(void)
 		torp[i].trail_num = NO_TRAIL;
 	}
 
-	/* set up torpedo display list */
-	torp_dl = glGenLists(1);
-	glNewList(torp_dl, GL_COMPILE);
-		glShadeModel(GL_SMOOTH);
-		glEnable(GL_BLEND);
-		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-		glMaterialfv(GL_FRONT, GL_AMBIENT_AND_DIFFUSE, ad0);
-		glMaterialfv(GL_FRONT, GL_EMISSION, emit0);
-		glutSolidSphere(TORP_RADIUS - 2 * TORP_RADIUS_DELTA, 10, 10);
-		glMaterialfv(GL_FRONT, GL_AMBIENT_AND_DIFFUSE, ad1);
-		glMaterialfv(GL_FRONT, GL_EMISSION, emit1);
-		glutSolidSphere(TORP_RADIUS - TORP_RADIUS_DELTA, 10, 10);
-		glMaterialfv(GL_FRONT, GL_AMBIENT_AND_DIFFUSE, ad2);
-		glMaterialfv(GL_FRONT, GL_EMISSION, emit2) ;
-		glutSolidSphere(TORP_RADIUS + TORP_RADIUS_DELTA, 10, 10);
-		glMaterialfv(GL_FRONT, GL_EMISSION, emit_off);
-		glMaterialfv(GL_FRONT, GL_AMBIENT_AND_DIFFUSE, emit_off);
-		glDisable(GL_BLEND);
-	glEndList();
-
-	/* set up the torpedo billboard */
-	k = 3; /* scaling factor */
-	torp_billboard_dl = glGenLists(1);
-	glNewList(torp_billboard_dl, GL_COMPILE);
-		glEnable(GL_BLEND);
-		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-		glBegin(GL_QUADS);
-			glTexCoord2f(1, 0);
-			glVertex3f(k / 2, -k / 2, 0);
-			glTexCoord2f(1, 1);
-			glVertex3f(k / 2, k / 2, 0);
-			glTexCoord2f(0, 1);
-			glVertex3f(-k / 2, k / 2, 0);
-			glTexCoord2f(0, 0);
-			glVertex3f(-k / 2, -k / 2, 0);
-		glEnd();
-		glDisable(GL_BLEND);
-	glEndList();
-
-	/* set up tracer torpedo light properties */
-	glLightfv(GL_LIGHT2, GL_DIFFUSE, diffuse);
-	glLightf(GL_LIGHT2, GL_SPOT_CUTOFF, 50);
 	return;
 }
 
@@ -178,6 +124,7 @@ void fire_torpedo(void)
 
 	/* set the initial position of the torpedo just in front of the player */
 	vec_addmul(&torp[i].pos, &pos, 2, &zaxis);
+	torp[i].prev_pos = torp[i].pos;
 	vec_addmul(&torp[i].pos_delta, &velocity, TORP_DELTA, &zaxis);
 	torp[i].bb_zrot = 0 ;
 
@@ -210,6 +157,7 @@ void process_torpedo_motion(int value)
 			continue;
 
 		++num_in_flight;
+		torp[i].prev_pos = torp[i].pos;
 		vec_addmul(&torp[i].pos, &torp[i].pos, dt, &torp[i].pos_delta);
 		torp[i].bb_zrot += TORP_BB_ZROT;
 
@@ -277,10 +225,12 @@ void process_torpedo_trails(void)
 	return;
 }
 
-void calc_torp_billboard_rot(const Vector *v, double *x, double *y)
+/* Angles that turn the billboard of a torp at v to face the eye */
+void calc_torp_billboard_rot(const Vector *eye, const Vector *v, double *x,
+    double *y)
 {
 	Vector temp;
-	vec_sub(&temp, &pos, v);
+	vec_sub(&temp, eye, v);
 	find_rotation_angles(&temp, x, y);
 	return;
 }
@@ -300,38 +250,3 @@ static int compare_torps(const void *pa, const void *pb)
 
 	return d2 - d1;
 }
-
-void draw_torp_plasma(void)
-{
-	float emit0[] = {1, 1, 1, 1}; /* torp material properties */
-	float ad0[]   = {0, 0, 0, 1};
-	int k;
-
-	glEnable(GL_BLEND);
-
-	for (k = 0; k < 20; ++k) { /* how about 20 plasma bolts for each torp */
-		/* use a random alpha component for each bolt */
-		ad0[3] = gen_rand_float(0, 1);
-
-		/* use random (and equal) values for red and green so bolts vary from blue to white */
-		emit0[0] = emit0[1] = gen_rand_float(0, 1);
-		glMaterialfv(GL_FRONT, GL_AMBIENT_AND_DIFFUSE, ad0);
-		glMaterialfv(GL_FRONT, GL_EMISSION, emit0);
-		glBegin(GL_LINES);
-		glVertex3f(0, 0, 0);
-
-		if (k % 7 == 0)
-			/* every once in a while draw a long plasma bolt */
-			glVertex3f(gen_rand_float(0, 2 * TORP_RADIUS) - TORP_RADIUS,
-			           gen_rand_float(0, 2 * TORP_RADIUS) - TORP_RADIUS,
-			           gen_rand_float(0, 2 * TORP_RADIUS) - TORP_RADIUS);
-		else
-			/* usually draw a short plasma bolt */
-			glVertex3f(gen_rand_float(0, TORP_RADIUS) - TORP_RADIUS / 2,
-			           gen_rand_float(0, TORP_RADIUS) - TORP_RADIUS / 2,
-			           gen_rand_float(0, TORP_RADIUS) - TORP_RADIUS / 2);
-		glEnd();
-	}
-	glDisable(GL_BLEND);
-	return;
-}
@@ -42,6 +42,8 @@ extern "C" {
 
 extern const Vector ZERO_VEC;
 #ifdef DECLARE_vecops
+extern void astvec_narrow(AstVec *, const Vector *);
+extern void astvec_widen(Vector *, const AstVec *);
 extern void vec_add(Vector *, const Vector *, const Vector *);
 extern void vec_addmul(Vector *, const Vector *, double, const Vector *);
 extern double vec_dist(const Vector *, const Vector *);
@@ -126,6 +128,32 @@ autolinkage void vec_zero(Vector *v)
 	return;
 }
 
+autolinkage void astvec_widen(Vector *r, const AstVec *a)
+{
+#ifdef AST_FLOAT32
+	r->x = a->x;
+	r->y = a->y;
+	r->z = a->z;
+	r->w = 0;
+#else
+	*r = *a;
+#endif
+	return;
+}
+
+autolinkage void astvec_narrow(AstVec *r, const Vector *v)
+{
+#ifdef AST_FLOAT32
+	r->x = v->x;
+	r->y = v->y;
+	r->z = v->z;
+	r->w = 0;
+#else
+	*r = *v;
+#endif
+	return;
+}
+
 #endif // IMPLEMENT_vecops
 
 #undef DECLARE_vecops
@@ -22,10 +22,25 @@
  *  Monroeville, PA 15146
  */
 
-#include <GL/glut.h>
+#include <math.h>
 #include "asteroids3D.h"
 #include "vecops.h"
 
+/*
+ * The eye's orientation is kept as a unit quaternion. Turning composes one
+small rotation per local axis onto it, and the axes below are derived from
+it afterwards, so they stay orthonormal to rounding error instead of
+drifting apart as they did when the axes themselves were rotated.
+Composing still lets |orient| creep away from 1 by an ulp or so per turn,
+which is taken out every ORIENT_RENORM_PERIOD turns.
+ */
+#define ORIENT_RENORM_PERIOD 64
+
+static void quat_mul_axis(Quat *, unsigned int, double);
+
+static Quat orient;         // eye's orientation
+static unsigned int turns;  // rotate_view() calls since the last renormalization
+
 Vector xaxis, yaxis, zaxis; // eye's local coordinate system
 Vector pos;                 // eye's position in space
 
@@ -36,45 +51,168 @@ void reset_view(void)
 	vec_zero(&pos);
 
 	/* initial axes are the standard unit axes */
-	xaxis.x = 1; xaxis.y = 0; xaxis.z = 0;
-	yaxis.x = 0; yaxis.y = 1; yaxis.z = 0;
-	zaxis.x = 0; zaxis.y = 0; zaxis.z = 1;
+	orient.w = 1;
+	orient.x = orient.y = orient.z = 0;
+	turns = 0;
+	orient_axes(&orient, &xaxis, &yaxis, &zaxis);
 
 	/*
 	 * for the purposes of this program, the view
 	 * is going to be fixed down the POSITIVE z axis
+	 * (gl_load_view() puts it into the modelview matrix)
 	 */
-	glMatrixMode(GL_MODELVIEW);
-	glLoadIdentity();
-	gluLookAt(pos.x, pos.y, pos.z,
-	          pos.x + zaxis.x, pos.y + zaxis.y, pos.z + zaxis.z,
-	          yaxis.x, yaxis.y, yaxis.z);
 	return;
 }
 
-void rotate_view_aboutx(double a)
+/* Turn the eye by a->x, a->y and a->z degrees about its x, y and z axes,
+in that order, each axis as left by the turn before */
+void rotate_view(const Vector *a)
+{
+	double n;
+
+	if (a->x == 0 && a->y == 0 && a->z == 0)
+		return;
+
+	quat_mul_axis(&orient, 0, a->x);
+	quat_mul_axis(&orient, 1, a->y);
+	quat_mul_axis(&orient, 2, a->z);
+
+	if (++turns >= ORIENT_RENORM_PERIOD) {
+		n = sqrt(orient.w * orient.w + orient.x * orient.x +
+		         orient.y * orient.y + orient.z * orient.z);
+		orient.w /= n;
+		orient.x /= n;
+		orient.y /= n;
+		orient.z /= n;
+		turns = 0;
+	}
+
+	orient_axes(&orient, &xaxis, &yaxis, &zaxis);
+	return;
+}
+
+/*
+ * Column-major view matrix for the eye, the one gluLookAt() makes when
+looking down zaxis with yaxis up: its rows are -xaxis, yaxis and -zaxis,
+followed by the move to the eye's position. The axes are orthonormal
+already, so none of gluLookAt()'s cross products and normalizing is needed.
+ */
+void view_matrix(double *m)
+{
+	eye_matrix(m, &pos, &xaxis, &yaxis, &zaxis);
+	return;
+}
+
+/* The same for an eye at p with axes x, y and z */
+void eye_matrix(double *m, const Vector *p, const Vector *x, const Vector *y,
+    const Vector *z)
+{
+	m[0] = -x->x; m[4] = -x->y; m[8]  = -x->z;
+	m[1] =  y->x; m[5] =  y->y; m[9]  =  y->z;
+	m[2] = -z->x; m[6] = -z->y; m[10] = -z->z;
+	m[3] = m[7] = m[11] = 0;
+	m[12] =  vec_dot(x, p);
+	m[13] = -vec_dot(y, p);
+	m[14] =  vec_dot(z, p);
+	m[15] = 1;
+	return;
+}
+
+/* The eye's orientation, which xaxis, yaxis and zaxis come from */
+void view_orient(Quat *q)
 {
-	double m[16];
-	find_rotation_mat(-a, &xaxis, m);
-	apply_v2m(&yaxis, m);
-	apply_v2m(&zaxis, m);
+	*q = orient;
 	return;
 }
 
-void rotate_view_abouty(double a)
+/* The axes are the columns of q's rotation matrix */
+void orient_axes(const Quat *q, Vector *x, Vector *y, Vector *z)
 {
-	double m[16];
-	find_rotation_mat(-a, &yaxis, m);
-	apply_v2m(&xaxis, m);
-	apply_v2m(&zaxis, m);
+	double xx = q->x * q->x, yy = q->y * q->y, zz = q->z * q->z;
+	double xy = q->x * q->y, xz = q->x * q->z, yz = q->y * q->z;
+	double wx = q->w * q->x, wy = q->w * q->y, wz = q->w * q->z;
+
+	x->x = 1 - 2 * (yy + zz);
+	x->y = 2 * (xy + wz);
+	x->z = 2 * (xz - wy);
+	y->x = 2 * (xy - wz);
+	y->y = 1 - 2 * (xx + zz);
+	y->z = 2 * (yz + wx);
+	z->x = 2 * (xz + wy);
+	z->y = 2 * (yz - wx);
+	z->z = 1 - 2 * (xx + yy);
+	x->w = y->w = z->w = 0;
 	return;
 }
 
-void rotate_view_aboutz(double a)
+/*
+ * r = the orientation fraction t of the way from a to b, along the shorter
+arc. Very close orientations are blended linearly and renormalized, where
+the sine below would lose its precision.
+ */
+void quat_slerp(Quat *r, const Quat *a, const Quat *b, double t)
 {
-	double m[16];
-	find_rotation_mat(-a, &zaxis, m);
-	apply_v2m(&xaxis, m);
-	apply_v2m(&yaxis, m);
+	double d = a->w * b->w + a->x * b->x + a->y * b->y + a->z * b->z;
+	double sb = 1, fa, fb, h, n;
+
+	if (d < 0) { /* b and -b are the same turn */
+		d  = -d;
+		sb = -1;
+	}
+	if (d > 0.9995) {
+		fa = 1 - t;
+		fb = t;
+	} else {
+		h  = acos(d);
+		fa = sin((1 - t) * h) / sin(h);
+		fb = sin(t * h) / sin(h);
+	}
+	fb *= sb;
+	r->w = fa * a->w + fb * b->w;
+	r->x = fa * a->x + fb * b->x;
+	r->y = fa * a->y + fb * b->y;
+	r->z = fa * a->z + fb * b->z;
+	n = sqrt(r->w * r->w + r->x * r->x + r->y * r->y + r->z * r->z);
+	r->w /= n;
+	r->x /= n;
+	r->y /= n;
+	r->z /= n;
+	return;
+}
+
+/*
+ * q = q * r, where r turns by -deg degrees about local axis 0, 1 or 2 (x, y
+or z). The minus keeps the sense of the matrix rotation this replaced,
+which turned the other two axes by -deg about the axis.
+ */
+static void quat_mul_axis(Quat *q, unsigned int axis, double deg)
+{
+	double h = -deg * M_PI / 360, c, s;
+	Quat p = *q;
+
+	if (deg == 0)
+		return;
+	c = cos(h);
+	s = sin(h);
+	switch (axis) {
+	case 0:
+		q->w = p.w * c - p.x * s;
+		q->x = p.x * c + p.w * s;
+		q->y = p.y * c + p.z * s;
+		q->z = p.z * c - p.y * s;
+		break;
+	case 1:
+		q->w = p.w * c - p.y * s;
+		q->x = p.x * c - p.z * s;
+		q->y = p.y * c + p.w * s;
+		q->z = p.z * c + p.x * s;
+		break;
+	default:
+		q->w = p.w * c - p.z * s;
+		q->x = p.x * c + p.y * s;
+		q->y = p.y * c - p.x * s;
+		q->z = p.z * c + p.w * s;
+		break;
+	}
 	return;
 }
@@ -0,0 +1,191 @@
+/* Asteroids3D - a first person game of blowing up asteroids
+ * Copyright (C) 2000 Stuart Mark Pomerantz <smp [at] psc edu>
+ * Copyright © Jan Engelhardt <jengelh [at] gmx de>, 2003 - 2006
+ *
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  Stuart Pomerantz
+ *  3935 Stonecliffe drive
+ *  Monroeville, PA 15146
+ */
+
+/*
+ * Drift test and microbenchmark of the eye's orientation, built by "make
+bench". The quaternion in view.c and the matrix rotation of the three axes
+it replaced are given the same random turns for many ticks. The test
+prints how far each set of axes has strayed from being orthonormal and
+how far the two sets have come apart, then times a turn on each path.
+It fails if the quaternion's axes stray further than DRIFT_BOUND, so "make
+check" runs it too.
+ *
+ * usage: view_bench [ticks]
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "asteroids3D.h"
+#include "vecops.h"
+
+#define BENCH_STEP (1.0 / 60) // dt at the default tick rate
+#define BENCH_DPS  75.0       // fastest turn, as MAX_DPS_INPUT in calc_frame.c
+#define NUM_TURNS  4096       // turns drawn up front for the timing runs
+
+/* Largest error from orthonormal allowed for the quaternion's axes. They
+stay near 1e-14 however long it turns; the matrix path passes this bound
+after about half a million ticks. */
+#define DRIFT_BOUND 1e-13
+
+static double axes_error(const Vector *);
+static void matrix_rotate(Vector *, const Vector *);
+static double time_matrix(const Vector *, unsigned int);
+static double time_quat(const Vector *, unsigned int);
+
+//-----------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+	unsigned long num_ticks = 10000000, i;
+	Vector turn, ax[3], qax[3], *turns;
+	double err, mat_err = 0, quat_err = 0, apart;
+	unsigned int k;
+
+	if (argc > 1)
+		num_ticks = strtoul(argv[1], NULL, 0);
+	if ((turns = calloc(NUM_TURNS, sizeof(Vector))) == NULL) {
+		perror("calloc");
+		return EXIT_FAILURE;
+	}
+
+	rng_seed(1);
+	reset_view();
+	ax[0] = xaxis;
+	ax[1] = yaxis;
+	ax[2] = zaxis;
+	vec_zero(&turn);
+
+	for (i = 0; i < num_ticks; ++i) {
+		gen_rand_floats(&turn.x, 3, 1, -BENCH_DPS * BENCH_STEP,
+		                BENCH_DPS * BENCH_STEP);
+		matrix_rotate(ax, &turn);
+		rotate_view(&turn);
+		if (i % 1000 == 0 || i == num_ticks - 1) {
+			if ((err = axes_error(ax)) > mat_err)
+				mat_err = err;
+			qax[0] = xaxis;
+			qax[1] = yaxis;
+			qax[2] = zaxis;
+			if ((err = axes_error(qax)) > quat_err)
+				quat_err = err;
+		}
+	}
+	qax[0] = xaxis;
+	qax[1] = yaxis;
+	qax[2] = zaxis;
+	for (apart = 0, k = 0; k < 3; ++k) {
+		vec_sub(&turn, &ax[k], &qax[k]);
+		if (vec_length(&turn) > apart)
+			apart = vec_length(&turn);
+	}
+
+	printf("%lu ticks of random turns up to %.0f deg/s\n", num_ticks,
+	       BENCH_DPS);
+	printf("  largest error from orthonormal: matrix %.3g, "
+	       "quaternion %.3g\n", mat_err, quat_err);
+	printf("  final axes of the two paths %.3g apart\n", apart);
+
+	for (k = 0; k < NUM_TURNS; ++k)
+		gen_rand_floats(&turns[k].x, 3, 1, -BENCH_DPS * BENCH_STEP,
+		                BENCH_DPS * BENCH_STEP);
+	printf("  matrix      %7.2f ns/turn\n", time_matrix(turns, 1000));
+	printf("  quaternion  %7.2f ns/turn\n", time_quat(turns, 1000));
+
+	free(turns);
+	if (quat_err > DRIFT_BOUND) {
+		fprintf(stderr, "The quaternion's axes drifted more than %g\n",
+		        DRIFT_BOUND);
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
+
+/* Largest deviation of the axes ax[0..2] from unit length and from being
+perpendicular */
+static double axes_error(const Vector *ax)
+{
+	double e = 0, d;
+	unsigned int i;
+
+	for (i = 0; i < 3; ++i) {
+		if ((d = fabs(vec_length(&ax[i]) - 1)) > e)
+			e = d;
+		if ((d = fabs(vec_dot(&ax[i], &ax[(i+1)%3]))) > e)
+			e = d;
+	}
+	return e;
+}
+
+/* The rotation of the axes that rotate_view() replaced */
+static void matrix_rotate(Vector *ax, const Vector *a)
+{
+	double m[16];
+
+	find_rotation_mat(-a->x, &ax[0], m);
+	apply_v2m(&ax[1], m);
+	apply_v2m(&ax[2], m);
+	find_rotation_mat(-a->y, &ax[1], m);
+	apply_v2m(&ax[0], m);
+	apply_v2m(&ax[2], m);
+	find_rotation_mat(-a->z, &ax[2], m);
+	apply_v2m(&ax[0], m);
+	apply_v2m(&ax[1], m);
+	return;
+}
+
+static double time_matrix(const Vector *turns, unsigned int rounds)
+{
+	struct timespec t0, t1;
+	Vector ax[3] = {{1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 1, 0}};
+	unsigned int r, k;
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (r = 0; r < rounds; ++r)
+		for (k = 0; k < NUM_TURNS; ++k)
+			matrix_rotate(ax, &turns[k]);
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	/* keep the work from being thrown away */
+	if (ax[0].x > 2)
+		putchar('\0');
+	return ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) /
+	       (static_cast(double, rounds) * NUM_TURNS);
+}
+
+static double time_quat(const Vector *turns, unsigned int rounds)
+{
+	struct timespec t0, t1;
+	unsigned int r, k;
+
+	reset_view();
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (r = 0; r < rounds; ++r)
+		for (k = 0; k < NUM_TURNS; ++k)
+			rotate_view(&turns[k]);
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	return ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) /
+	       (static_cast(double, rounds) * NUM_TURNS);
+}
@@ -40,6 +40,27 @@ void init_wind_parts(void)
 	return;
 }
 
+/* Renew the windshield particles whose time is up. Each of them hit the
+shield and takes it down a bit. The particles are only used while they are
+drawn. */
+void process_wind_parts(void)
+{
+	double secs;
+	int i, k;
+
+	if (expl_winshield_particle_count == 0 || !optmap.draw_shield_flag)
+		return;
+
+	secs = static_cast(double, ticks) / tps;
+	k = expl_winshield_particle_count * NUM_WP_PER_BLAST;
+	for (i = 0; i < k; ++i)
+		if (winshield_particle[i].t_end < secs) {
+			gen_rand_wind_part(&winshield_particle[i], secs);
+			shield_strength -= 1;
+		}
+	return;
+}
+
 void gen_rand_wind_part(WindPart *p, double secs)
 {
 	p->pos.x   = gen_rand_float(-1, 1);
@@ -0,0 +1,445 @@
+/* Asteroids3D - a first person game of blowing up asteroids
+ * Copyright (C) 2000 Stuart Mark Pomerantz <smp [at] psc edu>
+ * Copyright © Jan Engelhardt <jengelh [at] gmx de>, 2003 - 2006
+ *
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  Stuart Pomerantz
+ *  3935 Stonecliffe drive
+ *  Monroeville, PA 15146
+ */
+
+/*
+ * Job system. Every thread that submits jobs gets a JobQueue of its own:
+the pool's worker threads, and the sim and main threads as soon as they
+submit their first job. A thread pushes and pops its jobs at the bottom of
+its own queue; a thread that runs out of work steals from the top of the
+others', so the jobs spread over the cores without a shared queue to fight
+over. The queues are the deques of Chase and Lev, in the form for weak
+memory models given by Le, Pop, Cohen and Zappa Nardelli (PPoPP 2013).
+ *
+ * Jobs come from a ring of JOB_POOL_SIZE in the creating thread's queue, so
+creating one takes no lock or malloc. A thread waiting for a job runs other
+jobs meanwhile. Pool workers that find no work sleep on job_ready until a
+job is pushed.
+ *
+ * run_parallel() is the parallel-for on top: it splits [0, count) into one
+contiguous chunk per active worker, runs chunk 0 itself and the rest as
+children of one parent job, and waits for that. Which thread runs a chunk
+does not matter, as the chunks keep their numbers.
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "asteroids3D.h"
+
+/* Loops shorter than this many elements per chunk are not worth waking the
+pool for and run on the calling thread alone. */
+#define MIN_CHUNK_SIZE 1024
+
+#define JOB_QUEUE_SIZE 256 // jobs waiting in one queue, a power of two
+#define JOB_POOL_SIZE  256 // jobs one thread can have on the go
+#define MAX_JOB_QUEUES (MAX_WORKERS + 4) // the pool and the other threads
+
+/* Times a worker looks for work before it goes to sleep */
+#define IDLE_SPINS 64
+
+typedef struct job_queue {
+    long top;                   // next job to steal, moved by any thread
+    char pad0[64 - sizeof(long)];
+    long bottom;                // next free slot, moved by the owner only
+    Job *slot[JOB_QUEUE_SIZE];
+    Job pool[JOB_POOL_SIZE];    // jobs created by the owner
+    unsigned int next_job;      // next one to take from pool
+    int worker;                 // which pool thread owns it, -1 = none
+    /* Statistics of the owner, see print_worker_stats() */
+    unsigned long jobs_run, jobs_stolen, sleeps;
+    double busy;                // seconds spent running jobs
+    char pad1[64];
+} JobQueue;
+
+/* A chunk of a run_parallel() loop */
+struct chunk_arg {
+    WorkFunc func;
+    unsigned int chunk, first, last;
+};
+
+static int any_work(void);
+static void finish_job(Job *);
+static JobQueue *my_queue(void);
+static Job *next_job(JobQueue *);
+static Job *pop_job(JobQueue *);
+static int push_job(JobQueue *, Job *);
+static void run_chunk(void *);
+static void run_job(JobQueue *, Job *);
+static Job *steal_job(JobQueue *);
+static void *worker_main(void *);
+
+static JobQueue job_queue[MAX_JOB_QUEUES];
+static unsigned int num_queues;
+static __thread JobQueue *own_queue;
+
+static pthread_t worker_tid[MAX_WORKERS];
+static pthread_mutex_t job_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t job_ready = PTHREAD_COND_INITIALIZER;
+static unsigned int sleepers;           // workers waiting on job_ready
+
+static unsigned int num_workers = 1;    // threads in the pool, incl. caller
+static unsigned int active_workers = 1; // of these, how many take jobs
+static struct timespec start_time;      // for the utilisation figures
+
+//-----------------------------------------------------------------------------
+/* Start the pool with n threads, counting the caller; 0 = one per CPU */
+unsigned int init_workers(unsigned int n)
+{
+	long cpus;
+	unsigned int i;
+
+	clock_gettime(CLOCK_MONOTONIC, &start_time);
+	if (n == 0) {
+		cpus = sysconf(_SC_NPROCESSORS_ONLN);
+		n = (cpus > 0) ? cpus : 1;
+	}
+	if (n > MAX_WORKERS)
+		n = MAX_WORKERS;
+
+	for (i = num_workers; i < n; ++i)
+		if (pthread_create(&worker_tid[i], NULL, worker_main,
+		    reinterpret_cast(void *, static_cast(uintptr_t, i))) != 0)
+		{
+			fprintf(stderr, "Could not start worker thread %u, "
+			        "continuing with %u\n", i, i);
+			break;
+		}
+
+	/* the new workers are already reading it */
+	num_workers = i;
+	__atomic_store_n(&active_workers, i, __ATOMIC_RELAXED);
+	return num_workers;
+}
+
+/* Limit later run_parallel() calls to n chunks, and the pool to its first
+n threads */
+unsigned int set_active_workers(unsigned int n)
+{
+	if (n == 0 || n > num_workers)
+		n = num_workers;
+	__atomic_store_n(&active_workers, n, __ATOMIC_RELAXED);
+	pthread_mutex_lock(&job_lock);
+	pthread_cond_broadcast(&job_ready);
+	pthread_mutex_unlock(&job_lock);
+	return n;
+}
+
+/* A new job that runs func(arg) once submitted. With a parent, the parent
+does not finish before it. */
+Job *create_job(JobFunc func, void *arg, Job *parent)
+{
+	JobQueue *q = my_queue();
+	Job *j = &q->pool[q->next_job++ % JOB_POOL_SIZE];
+
+	/* only when that many jobs are still not done */
+	if (__atomic_load_n(&j->unfinished, __ATOMIC_ACQUIRE) != 0)
+		wait_job(j);
+
+	j->func       = func;
+	j->arg        = arg;
+	j->parent     = parent;
+	j->unfinished = 1;
+	if (parent != NULL)
+		__atomic_fetch_add(&parent->unfinished, 1, __ATOMIC_RELAXED);
+	return j;
+}
+
+/* Hand a job to the pool. It is run at once if the queue is full. */
+void submit_job(Job *j)
+{
+	JobQueue *q = my_queue();
+
+	if (!push_job(q, j)) {
+		run_job(q, j);
+		return;
+	}
+
+	/* pairs with the fence in any_work(): either a worker about to sleep
+	sees the job, or we see it is sleeping and wake it */
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if (__atomic_load_n(&sleepers, __ATOMIC_RELAXED) > 0) {
+		pthread_mutex_lock(&job_lock);
+		pthread_cond_signal(&job_ready);
+		pthread_mutex_unlock(&job_lock);
+	}
+	return;
+}
+
+/* Run jobs until j and its children have finished */
+void wait_job(Job *j)
+{
+	JobQueue *q = my_queue();
+	Job *next;
+
+	while (__atomic_load_n(&j->unfinished, __ATOMIC_ACQUIRE) != 0) {
+		if ((next = next_job(q)) != NULL)
+			run_job(q, next);
+		else
+			sched_yield();
+	}
+	return;
+}
+
+void run_parallel(WorkFunc func, unsigned int count)
+{
+	unsigned int chunks = __atomic_load_n(&active_workers,
+	                      __ATOMIC_RELAXED);
+	struct chunk_arg arg[MAX_WORKERS];
+	unsigned int k;
+	Job *root;
+
+	if (count / chunks < MIN_CHUNK_SIZE)
+		chunks = count / MIN_CHUNK_SIZE;
+	if (chunks <= 1) {
+		func(0, 0, count);
+		return;
+	}
+
+	root = create_job(NULL, NULL, NULL);
+	for (k = 0; k < chunks; ++k) {
+		arg[k].func  = func;
+		arg[k].chunk = k;
+		/* 64-bit products so count * k cannot overflow */
+		arg[k].first = static_cast(unsigned long long, count) * k / chunks;
+		arg[k].last  = static_cast(unsigned long long, count) * (k + 1) /
+		               chunks;
+		if (k > 0)
+			submit_job(create_job(run_chunk, &arg[k], root));
+	}
+	run_chunk(&arg[0]);
+	finish_job(root);
+	wait_job(root);
+	return;
+}
+
+static void run_chunk(void *p)
+{
+	const struct chunk_arg *a = p;
+
+	a->func(a->chunk, a->first, a->last);
+	return;
+}
+
+static void run_job(JobQueue *q, Job *j)
+{
+	struct timespec t0, t1;
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	if (j->func != NULL)
+		j->func(j->arg);
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	q->busy += (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+	++q->jobs_run;
+	finish_job(j);
+	return;
+}
+
+/* Count j and then its ancestors down, for as long as that finishes them.
+Once a count reaches 0, whoever waits on that job may reuse or free it, so
+its parent is read before the decrement. */
+static void finish_job(Job *j)
+{
+	Job *parent;
+
+	while (j != NULL) {
+		parent = j->parent;
+		if (__atomic_sub_fetch(&j->unfinished, 1,
+		    __ATOMIC_ACQ_REL) != 0)
+			break;
+		j = parent;
+	}
+	return;
+}
+
+/* The calling thread's queue, which it gets on first use */
+static JobQueue *my_queue(void)
+{
+	unsigned int i;
+
+	if (own_queue != NULL)
+		return own_queue;
+	i = __atomic_fetch_add(&num_queues, 1, __ATOMIC_ACQ_REL);
+	if (i >= MAX_JOB_QUEUES) {
+		fprintf(stderr, "More than %u threads use the job system\n",
+		        MAX_JOB_QUEUES);
+		abort();
+	}
+	job_queue[i].worker = -1;
+	return own_queue = &job_queue[i];
+}
+
+/* A job from our own queue, or else one stolen from another */
+static Job *next_job(JobQueue *q)
+{
+	unsigned int n = __atomic_load_n(&num_queues, __ATOMIC_ACQUIRE);
+	unsigned int start, i;
+	Job *j;
+
+	if ((j = pop_job(q)) != NULL)
+		return j;
+	start = q - job_queue;
+	for (i = 1; i < n; ++i)
+		if ((j = steal_job(&job_queue[(start + i) % n])) != NULL) {
+			++q->jobs_stolen;
+			return j;
+		}
+	return NULL;
+}
+
+/* Owner only. Returns 0 if the queue is full. */
+static int push_job(JobQueue *q, Job *j)
+{
+	long b = __atomic_load_n(&q->bottom, __ATOMIC_RELAXED);
+	long t = __atomic_load_n(&q->top, __ATOMIC_ACQUIRE);
+
+	if (b - t >= JOB_QUEUE_SIZE)
+		return 0;
+	__atomic_store_n(&q->slot[b % JOB_QUEUE_SIZE], j, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	__atomic_store_n(&q->bottom, b + 1, __ATOMIC_RELAXED);
+	return 1;
+}
+
+/* Owner only: the job pushed last */
+static Job *pop_job(JobQueue *q)
+{
+	long b = __atomic_load_n(&q->bottom, __ATOMIC_RELAXED) - 1;
+	long t;
+	Job *j = NULL;
+
+	__atomic_store_n(&q->bottom, b, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	t = __atomic_load_n(&q->top, __ATOMIC_RELAXED);
+	if (t <= b) {
+		j = __atomic_load_n(&q->slot[b % JOB_QUEUE_SIZE],
+		    __ATOMIC_RELAXED);
+		if (t != b)
+			return j;
+		/* the last job: race the thieves for it */
+		if (!__atomic_compare_exchange_n(&q->top, &t, t + 1, 0,
+		    __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+			j = NULL;
+	}
+	__atomic_store_n(&q->bottom, b + 1, __ATOMIC_RELAXED);
+	return j;
+}
+
+/* Any thread: the job pushed first, or NULL if there is none or another
+thread got it first */
+static Job *steal_job(JobQueue *q)
+{
+	long t = __atomic_load_n(&q->top, __ATOMIC_ACQUIRE);
+	long b;
+	Job *j;
+
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	b = __atomic_load_n(&q->bottom, __ATOMIC_ACQUIRE);
+	if (t >= b)
+		return NULL;
+	j = __atomic_load_n(&q->slot[t % JOB_QUEUE_SIZE], __ATOMIC_RELAXED);
+	if (!__atomic_compare_exchange_n(&q->top, &t, t + 1, 0,
+	    __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+		return NULL;
+	return j;
+}
+
+/* Is there a job in any queue? */
+static int any_work(void)
+{
+	unsigned int n = __atomic_load_n(&num_queues, __ATOMIC_ACQUIRE);
+	unsigned int i;
+
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	for (i = 0; i < n; ++i)
+		if (__atomic_load_n(&job_queue[i].top, __ATOMIC_RELAXED) <
+		    __atomic_load_n(&job_queue[i].bottom, __ATOMIC_RELAXED))
+			return 1;
+	return 0;
+}
+
+static void *worker_main(void *arg)
+{
+	unsigned int id = reinterpret_cast(uintptr_t, arg);
+	unsigned int spins = 0;
+	JobQueue *q = my_queue();
+	Job *j;
+
+	q->worker = id;
+	rng_select(RNG_WORKER + id);
+	for (;;) {
+		if (id < __atomic_load_n(&active_workers, __ATOMIC_RELAXED) &&
+		    (j = next_job(q)) != NULL) {
+			run_job(q, j);
+			spins = 0;
+			continue;
+		}
+		if (++spins < IDLE_SPINS) {
+			sched_yield();
+			continue;
+		}
+
+		pthread_mutex_lock(&job_lock);
+		__atomic_fetch_add(&sleepers, 1, __ATOMIC_SEQ_CST);
+		while (id >= __atomic_load_n(&active_workers, __ATOMIC_RELAXED) ||
+		       !any_work()) {
+			++q->sleeps;
+			pthread_cond_wait(&job_ready, &job_lock);
+		}
+		__atomic_fetch_sub(&sleepers, 1, __ATOMIC_RELAXED);
+		pthread_mutex_unlock(&job_lock);
+		spins = 0;
+	}
+	return NULL;
+}
+
+/* Share of the time since init_workers() each thread spent running jobs */
+void print_worker_stats(void)
+{
+	unsigned int n = __atomic_load_n(&num_queues, __ATOMIC_ACQUIRE);
+	struct timespec now;
+	const JobQueue *q;
+	double wall;
+	unsigned int i;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	wall = (now.tv_sec - start_time.tv_sec) +
+	       (now.tv_nsec - start_time.tv_nsec) / 1e9;
+	printf("Job system: %u worker thread(s), %u thread(s) with a queue\n",
+	       num_workers, n);
+	for (i = 0; i < n; ++i) {
+		q = &job_queue[i];
+		if (q->worker >= 0)
+			printf("  worker %2d:", q->worker);
+		else
+			printf("  other    :");
+		printf(" %5.1f%% busy, %lu jobs run, %lu stolen, %lu sleeps\n",
+		       (wall > 0) ? 100 * q->busy / wall : 0, q->jobs_run,
+		       q->jobs_stolen, q->sleeps);
+	}
+	return;
+}